@@ -0,0 +1,420 @@
+// Microbenchmarks for the image and encoding pipeline.
+//
+//   bench [--assets <dir>] [--only <substring>] [--quick]
+//         [--save <baseline.json>] [--compare <baseline.json>] [--threshold <percent>]
+//
+// Every stage runs on the calling thread (no thread pool), so results do not
+// depend on the core count and can be compared between machines of one kind.
+
+#include "dither.hpp"
+#include "image.hpp"
+#include "protocol.hpp"
+#include "transport_emulator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_ASSET_DIR
+#define BENCH_ASSET_DIR "."
+#endif
+
+// --- Allocation counting ---
+
+// Every operator new in the process goes through here, so a case can report how
+// many heap allocations one run of its stage makes
+static std::atomic<uint64_t> g_allocs{0};
+static std::atomic<uint64_t> g_alloc_bytes{0};
+
+static void* counted_alloc(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+// --- Cases ---
+
+namespace {
+
+/// One measured stage on one input
+struct BenchCase {
+    std::string name;           // "<stage>/<input>/<geometry>"
+    long pixels;                // Pixels the stage produces per run (for ns/pixel)
+    std::function<size_t()> run;  // Returns the bytes that would go on the wire (0: none)
+};
+
+struct BenchResult {
+    std::string name;
+    double ns_per_pixel = 0.0;  // Median over samples
+    double ms_per_run = 0.0;
+    double allocs = 0.0;        // Heap allocations per run
+    double alloc_bytes = 0.0;   // Bytes requested per run
+    size_t wire_bytes = 0;      // APDU or compressed bytes per run
+};
+
+struct BenchSettings {
+    int samples = 7;
+    double sample_ms = 40.0;  // Each sample repeats the stage for at least this long
+};
+
+// Keeps results alive so the optimizer cannot drop the work
+volatile size_t g_sink = 0;
+
+BenchResult measure(const BenchCase& c, const BenchSettings& settings) {
+    using Clock = std::chrono::steady_clock;
+    BenchResult r;
+    r.name = c.name;
+
+    // Warm-up run (first-use statics, thread-local work memory), then one counted
+    // for allocations and wire bytes
+    g_sink += c.run();
+    uint64_t allocs0 = g_allocs.load(), bytes0 = g_alloc_bytes.load();
+    r.wire_bytes = c.run();
+    r.allocs = (double)(g_allocs.load() - allocs0);
+    r.alloc_bytes = (double)(g_alloc_bytes.load() - bytes0);
+
+    // Size each sample from one timed run
+    auto t0 = Clock::now();
+    g_sink += c.run();
+    double once_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    int reps = std::max(1, (int)(settings.sample_ms / std::max(once_ms, 1e-3)));
+
+    std::vector<double> per_run_ms;
+    for (int s = 0; s < settings.samples; s++) {
+        auto start = Clock::now();
+        for (int i = 0; i < reps; i++) g_sink += c.run();
+        per_run_ms.push_back(
+            std::chrono::duration<double, std::milli>(Clock::now() - start).count() / reps);
+    }
+    std::sort(per_run_ms.begin(), per_run_ms.end());
+    r.ms_per_run = per_run_ms[per_run_ms.size() / 2];
+    r.ns_per_pixel = r.ms_per_run * 1e6 / (double)std::max(1L, c.pixels);
+    return r;
+}
+
+DeviceInfo panel_info(const std::string& name) {
+    return parse_device_info(build_device_info_response(emulated_panel(name)));
+}
+
+size_t apdu_bytes(const std::vector<std::vector<Apdu>>& blocks) {
+    size_t bytes = 0;
+    for (const auto& block : blocks) {
+        for (const auto& apdu : block) {
+            bytes += 4 + (apdu.has_data ? 1 + apdu.data.size() : 0) + (apdu.le >= 0 ? 1 : 0);
+        }
+    }
+    return bytes;
+}
+
+// Large photo-like source for the resize path: gradients plus fine detail,
+// written as binary PPM (decoded by stb_image like the bundled files)
+std::string write_synthetic_image(int width, int height) {
+    auto path = std::filesystem::temp_directory_path() /
+                ("send_epaper_bench_" + std::to_string(width) + "x" + std::to_string(height) + ".ppm");
+    if (std::filesystem::exists(path)) return path.string();
+
+    std::vector<uint8_t> rgb = {};
+    rgb.reserve((size_t)width * height * 3);
+    uint32_t noise = 0x9E3779B9u;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            noise = noise * 1664525u + 1013904223u;
+            int grain = (int)(noise >> 28) - 8;
+            rgb.push_back((uint8_t)std::clamp(x * 255 / width + grain, 0, 255));
+            rgb.push_back((uint8_t)std::clamp(y * 255 / height + grain, 0, 255));
+            rgb.push_back((uint8_t)std::clamp(((x ^ y) & 0xFF) + grain, 0, 255));
+        }
+    }
+    std::ofstream out(path, std::ios::binary);
+    out << "P6\n" << width << " " << height << "\n255\n";
+    out.write((const char*)rgb.data(), (std::streamsize)rgb.size());
+    if (!out) throw std::runtime_error("Cannot write " + path.string());
+    return path.string();
+}
+
+// Same kind of content at any size, without going through a file
+std::vector<uint8_t> synthetic_rgb(int width, int height) {
+    std::vector<uint8_t> rgb((size_t)width * height * 3);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < rgb.size(); i++) {
+        noise = noise * 1664525u + 1013904223u;
+        size_t pixel = i / 3;
+        int x = (int)(pixel % width), y = (int)(pixel / width);
+        int base = i % 3 == 0 ? x * 255 / width : i % 3 == 1 ? y * 255 / height : (x ^ y) & 0xFF;
+        rgb[i] = (uint8_t)std::clamp(base + (int)(noise >> 28) - 8, 0, 255);
+    }
+    return rgb;
+}
+
+// Every stage on one (source image, panel) pair. Inputs of later stages are
+// computed once here, so each case times only its own stage.
+void add_panel_cases(std::vector<BenchCase>& cases, const std::string& label,
+                     const std::string& path, const std::string& panel) {
+    DeviceInfo info = panel_info(panel);
+    int w = info.width, h = info.height;
+    long pixels = (long)w * h;
+    std::string suffix = "/" + label + "/" + panel;
+    Color bg = {255, 255, 255};
+
+    auto rgb = std::make_shared<std::vector<uint8_t>>(load_and_resize_image(path.c_str(), w, h, bg));
+    auto pixels_fb = std::make_shared<Framebuffer>(dither_atkinson(*rgb, w, h, default_quantizer(), nullptr));
+    auto packed = std::make_shared<std::vector<uint8_t>>(pack_framebuffer(*pixels_fb, info));
+    auto blocks = std::make_shared<std::vector<std::vector<uint8_t>>>(split_blocks(*packed, info.block_sizes()));
+
+    cases.push_back({"load_and_resize_image" + suffix, pixels, [path, w, h, bg] {
+        g_sink += load_and_resize_image(path.c_str(), w, h, bg).size();
+        return (size_t)0;
+    }});
+    cases.push_back({"dither_atkinson" + suffix, pixels, [rgb, w, h] {
+        g_sink += dither_atkinson(*rgb, w, h, default_quantizer(), nullptr).size_bytes();
+        return (size_t)0;
+    }});
+    cases.push_back({"dither_none" + suffix, pixels, [rgb, w, h] {
+        g_sink += dither_none(*rgb, w, h).size_bytes();
+        return (size_t)0;
+    }});
+    cases.push_back({"rotate_cw90" + suffix, pixels, [pixels_fb] {
+        g_sink += rotate_cw90(*pixels_fb).size_bytes();
+        return (size_t)0;
+    }});
+    cases.push_back({"pack_pixels" + suffix, pixels, [pixels_fb, info] {
+        g_sink += pack_pixels(*pixels_fb, info.bits_per_pixel).size();
+        return (size_t)0;
+    }});
+    cases.push_back({"compress_block" + suffix, pixels, [blocks] {
+        size_t out = 0;
+        for (const auto& block : *blocks) out += compress_block(block).size();
+        return out;
+    }});
+    for (LzoLevel level : {LzoLevel::Best, LzoLevel::Smallest}) {
+        cases.push_back({std::string("compress_block_") + lzo_level_name(level) + suffix, pixels,
+                         [blocks, level] {
+            size_t out = 0;
+            for (const auto& block : *blocks) out += compress_block(block, level).size();
+            return out;
+        }});
+    }
+    cases.push_back({"encode_image" + suffix, pixels, [pixels_fb, info] {
+        return apdu_bytes(encode_image(*pixels_fb, info, nullptr));
+    }});
+}
+
+// Stages that do not depend on a panel, on a frame much larger than any panel
+void add_large_cases(std::vector<BenchCase>& cases, int w, int h) {
+    long pixels = (long)w * h;
+    std::string suffix = "/synthetic/" + std::to_string(w) + "x" + std::to_string(h);
+    auto rgb = std::make_shared<std::vector<uint8_t>>(synthetic_rgb(w, h));
+    auto fb = std::make_shared<Framebuffer>(dither_atkinson(*rgb, w, h, default_quantizer(), nullptr));
+    auto packed = std::make_shared<std::vector<uint8_t>>(pack_pixels(*fb, 2));
+
+    cases.push_back({"dither_atkinson" + suffix, pixels, [rgb, w, h] {
+        g_sink += dither_atkinson(*rgb, w, h, default_quantizer(), nullptr).size_bytes();
+        return (size_t)0;
+    }});
+    cases.push_back({"dither_none" + suffix, pixels, [rgb, w, h] {
+        g_sink += dither_none(*rgb, w, h).size_bytes();
+        return (size_t)0;
+    }});
+    cases.push_back({"rotate_cw90" + suffix, pixels, [fb] {
+        g_sink += rotate_cw90(*fb).size_bytes();
+        return (size_t)0;
+    }});
+    cases.push_back({"pack_pixels" + suffix, pixels, [fb] {
+        g_sink += pack_pixels(*fb, 2).size();
+        return (size_t)0;
+    }});
+    cases.push_back({"compress_block" + suffix, pixels, [packed] {
+        // In card-sized 2000-byte blocks, like a real upload
+        size_t out = 0;
+        for (size_t off = 0; off < packed->size(); off += 2000) {
+            out += compress_block(packed->data() + off, std::min<size_t>(2000, packed->size() - off)).size();
+        }
+        return out;
+    }});
+}
+
+// --- Baselines ---
+
+std::string to_json(const std::vector<BenchResult>& results) {
+    std::ostringstream out;
+    out << std::setprecision(6) << "{\n  \"results\": [";
+    const char* sep = "";
+    for (const auto& r : results) {
+        // One result per line: --compare reads the file back line by line
+        out << sep << "\n    {\"name\": \"" << r.name << "\", \"ns_per_pixel\": " << r.ns_per_pixel
+            << ", \"ms_per_run\": " << r.ms_per_run << ", \"allocs\": " << r.allocs
+            << ", \"alloc_bytes\": " << r.alloc_bytes << ", \"wire_bytes\": " << r.wire_bytes << "}";
+        sep = ",";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+// Numeric field of one result line written by to_json
+bool json_field(const std::string& line, const std::string& key, double& value) {
+    auto pos = line.find("\"" + key + "\": ");
+    if (pos == std::string::npos) return false;
+    value = std::strtod(line.c_str() + pos + key.size() + 4, nullptr);
+    return true;
+}
+
+std::map<std::string, BenchResult> load_baseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot open baseline: " + path);
+    std::map<std::string, BenchResult> baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        auto start = line.find("{\"name\": \"");
+        if (start == std::string::npos) continue;
+        start += 10;
+        BenchResult r;
+        r.name = line.substr(start, line.find('"', start) - start);
+        double wire = 0;
+        json_field(line, "ns_per_pixel", r.ns_per_pixel);
+        json_field(line, "ms_per_run", r.ms_per_run);
+        json_field(line, "allocs", r.allocs);
+        json_field(line, "alloc_bytes", r.alloc_bytes);
+        json_field(line, "wire_bytes", wire);
+        r.wire_bytes = (size_t)wire;
+        baseline[r.name] = r;
+    }
+    return baseline;
+}
+
+void print_usage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options]\n"
+              << "\n"
+              << "Options:\n"
+              << "  --assets <dir>           Directory with the bundled images (default: source tree)\n"
+              << "  --only <text>            Run only cases whose name contains this text\n"
+              << "  --quick                  Fewer, shorter samples (noisier)\n"
+              << "  --save <file>            Write the results as a JSON baseline\n"
+              << "  --compare <file>         Compare with a baseline written by --save\n"
+              << "  --threshold <percent>    With --compare: slowdown that fails the run (default: 10)\n"
+              << "  --help                   Show this help message\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string assets = BENCH_ASSET_DIR;
+    std::string only;
+    std::string save_path;
+    std::string compare_path;
+    double threshold = 10.0;
+    BenchSettings settings;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--assets" && i + 1 < argc) {
+            assets = argv[++i];
+        } else if (arg == "--only" && i + 1 < argc) {
+            only = argv[++i];
+        } else if (arg == "--quick") {
+            settings.samples = 3;
+            settings.sample_ms = 10.0;
+        } else if (arg == "--save" && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (arg == "--compare" && i + 1 < argc) {
+            compare_path = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        std::vector<BenchCase> cases;
+        const std::vector<std::pair<std::string, std::string>> images = {
+            {"image.jpg", assets + "/image.jpg"},
+            {"image.png", assets + "/image.png"},
+            {"artist400x300.png", assets + "/artist400x300.png"},
+            {"hello_badge_128x296.png", assets + "/hello_badge_128x296.png"},
+            {"synthetic4000x3000", write_synthetic_image(4000, 3000)},
+        };
+        for (const auto& [label, path] : images) {
+            for (const char* panel : {"128x296", "400x300"}) {
+                add_panel_cases(cases, label, path, panel);
+            }
+        }
+        add_large_cases(cases, 2048, 2048);
+
+        std::map<std::string, BenchResult> baseline;
+        if (!compare_path.empty()) baseline = load_baseline(compare_path);
+
+        std::vector<BenchResult> results;
+        int regressions = 0;
+        std::cout << std::left << std::setw(56) << "case" << std::right << std::setw(10) << "ns/px"
+                  << std::setw(11) << "ms/run" << std::setw(9) << "allocs" << std::setw(11)
+                  << "wire B" << (baseline.empty() ? "" : "   vs baseline") << "\n";
+        for (const auto& c : cases) {
+            if (!only.empty() && c.name.find(only) == std::string::npos) continue;
+            auto r = measure(c, settings);
+            results.push_back(r);
+
+            std::cout << std::left << std::setw(56) << r.name << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(10) << r.ns_per_pixel << std::setprecision(3)
+                      << std::setw(11) << r.ms_per_run << std::setprecision(0) << std::setw(9) << r.allocs
+                      << std::setw(11) << r.wire_bytes;
+            auto it = baseline.find(r.name);
+            if (it != baseline.end() && it->second.ns_per_pixel > 0) {
+                double change = (r.ns_per_pixel / it->second.ns_per_pixel - 1.0) * 100.0;
+                bool slower = change > threshold;
+                regressions += slower;
+                std::cout << std::showpos << std::setprecision(1) << std::setw(10) << change << "%"
+                          << std::noshowpos;
+                if (r.allocs != it->second.allocs) {
+                    std::cout << " allocs " << std::setprecision(0) << it->second.allocs << "->" << r.allocs;
+                }
+                if (r.wire_bytes != it->second.wire_bytes) {
+                    std::cout << " wire " << it->second.wire_bytes << "->" << r.wire_bytes;
+                }
+                if (slower) std::cout << "  SLOWER";
+            }
+            std::cout << std::endl;
+        }
+
+        if (!save_path.empty()) {
+            std::ofstream out(save_path);
+            out << to_json(results);
+            if (!out) throw std::runtime_error("Cannot write " + save_path);
+            std::cout << "Baseline saved to " << save_path << std::endl;
+        }
+        if (regressions > 0) {
+            std::cout << regressions << " case(s) more than " << threshold << "% slower than "
+                      << compare_path << std::endl;
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// A rendered image ready for transmission: the packed framebuffer and the
+/// image-data APDUs built from it, grouped by block
+struct EncodedImage {
+    std::vector<uint8_t> packed;
+    std::vector<std::vector<Apdu>> blocks;
+
+    size_t fragment_count() const;
+};
+
+/// 64-bit FNV-1a; pass a previous result as `hash` to extend it
+uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL);
+
+/// Serialize / parse an EncodedImage (versioned, checksummed binary layout).
+/// Parsing throws std::runtime_error on truncated or corrupt input.
+std::vector<uint8_t> serialize_encoded_image(const EncodedImage& image);
+EncodedImage deserialize_encoded_image(const uint8_t* data, size_t size);
+
+/// Per-user cache directory: $SEND_EPAPER_CACHE_DIR, else $XDG_CACHE_HOME/send_epaper,
+/// else ~/.cache/send_epaper. Empty if none can be determined.
+std::string default_cache_dir();
+
+/// Hit/miss counters of an ApduCache
+struct ApduCacheStats {
+    int memory_hits = 0;
+    int disk_hits = 0;
+    int misses = 0;
+    int stores = 0;
+    int evictions = 0;  // Disk entries removed to stay within the budget
+};
+
+/// Content-addressed cache of encoded images.
+///
+/// Keys are hashes of everything that determines the APDU stream (see
+/// render_cache_key). Recently used entries stay in memory (LRU); every entry
+/// is also written to `<dir>/<key>.apdu` so later runs can skip decode, dither
+/// and compression. The directory is kept within `disk_bytes`: when a store
+/// goes over, the files used least recently (oldest mtime; hits touch their
+/// file) are removed. Thread-safe.
+class ApduCache {
+public:
+    static constexpr uint64_t DEFAULT_DISK_BYTES = 64ull << 20;
+
+    /// `dir` empty or `disk_bytes` 0: memory only
+    explicit ApduCache(std::string dir, size_t memory_entries = 64,
+                       uint64_t disk_bytes = DEFAULT_DISK_BYTES);
+
+    /// Cached image for `key`, or nullptr
+    std::shared_ptr<const EncodedImage> find(uint64_t key);
+
+    /// Insert into memory and write through to disk, evicting old files if the
+    /// directory goes over budget (disk errors are ignored)
+    void store(uint64_t key, std::shared_ptr<const EncodedImage> image);
+
+    const std::string& dir() const { return dir_; }
+    ApduCacheStats stats() const;
+
+private:
+    std::string path_for(uint64_t key) const;
+    void remember(uint64_t key, std::shared_ptr<const EncodedImage> image);
+    void trim_disk(uint64_t added);
+
+    std::string dir_;
+    size_t capacity_;
+    uint64_t disk_budget_;
+    std::mutex disk_mutex_;           // Serializes trim_disk
+    int64_t disk_used_ = -1;          // Bytes in dir_ as of the last scan plus stores since; -1: not scanned
+    mutable std::mutex mutex_;
+    std::list<std::pair<uint64_t, std::shared_ptr<const EncodedImage>>> lru_;  // Front: newest
+    std::unordered_map<uint64_t, decltype(lru_)::iterator> index_;
+    ApduCacheStats stats_;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "nfc_transport.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// One event of an APDU trace
+struct TraceEvent {
+    enum Kind : uint8_t {
+        Card = 1,      // open() or wait_for_card() activated a card
+        NoCard = 2,    // wait_for_card() timed out
+        Presence = 3,  // card_present() and its answer
+        Exchange = 4,  // send_apdu() and its response or error
+    };
+
+    Kind kind = Exchange;
+    uint64_t start_us = 0;     // Since the trace started
+    uint32_t duration_us = 0;  // Time spent in the transport call
+
+    // Card: what the transport reported for it
+    CardDetection detection;
+    int max_unchained_apdu = 0;
+
+    // Presence: the answer
+    bool present = false;
+
+    // Exchange
+    Apdu apdu{};
+    std::vector<uint8_t> response;  // Without status word
+    uint16_t status = 0x9000;       // Status word of an ApduStatusError; 0 for link errors
+    std::string error;              // Empty if send_apdu returned
+    int wtx = 0;
+};
+
+/// Read a whole trace file; throws on a missing or malformed file
+std::vector<TraceEvent> load_trace(const std::string& path);
+
+/// Transport decorator that forwards every call to `inner` and appends what
+/// happened to a binary trace file (see src/apdu_trace.cpp for the format).
+/// Each event is flushed as it completes, so a crash or a pulled reader still
+/// leaves the trace up to the failure.
+class TraceRecorder : public NfcTransport {
+public:
+    TraceRecorder(std::unique_ptr<NfcTransport> inner, const std::string& path);
+
+    void open() override;
+    void open_reader() override { inner_->open_reader(); }
+    bool wait_for_card(std::chrono::milliseconds timeout) override;
+    void set_polling(const PollSettings& settings) override { inner_->set_polling(settings); }
+    CardDetection last_detection() const override { return inner_->last_detection(); }
+    bool card_present() override;
+    void close() override { inner_->close(); }
+    std::vector<uint8_t> send_apdu(const Apdu& apdu) override;
+    int last_apdu_wtx() const override { return inner_->last_apdu_wtx(); }
+    int max_unchained_apdu() const override { return inner_->max_unchained_apdu(); }
+
+    /// Events written so far
+    int events() const { return events_; }
+
+private:
+    uint64_t since_start_us(std::chrono::steady_clock::time_point t) const;
+    void write(TraceEvent& event, std::chrono::steady_clock::time_point start);
+    void card_event(bool found, std::chrono::steady_clock::time_point start);
+
+    std::unique_ptr<NfcTransport> inner_;
+    std::ofstream file_;
+    std::string path_;
+    std::chrono::steady_clock::time_point start_;
+    int events_ = 0;
+};
+
+/// Plays a recorded trace back as a card: no reader needed.
+///
+/// Every send_apdu must match the next recorded command byte for byte (the same
+/// image, options and cache state as the recorded run); it then returns the
+/// recorded response or throws the recorded error. Timed replay sleeps for each
+/// call's recorded duration, so uploads take as long as they did on the card;
+/// fast replay returns at once and leaves only the host's own work to measure.
+class TraceReplayTransport : public NfcTransport {
+public:
+    enum class Timing { Recorded, Fast };
+
+    explicit TraceReplayTransport(std::vector<TraceEvent> events, Timing timing = Timing::Recorded);
+
+    void open() override;
+    bool wait_for_card(std::chrono::milliseconds timeout) override;
+    CardDetection last_detection() const override { return detection_; }
+    bool card_present() override;
+    void close() override {}
+    std::vector<uint8_t> send_apdu(const Apdu& apdu) override;
+    int last_apdu_wtx() const override { return wtx_; }
+    int max_unchained_apdu() const override { return max_unchained_; }
+
+    /// Events not played yet
+    size_t remaining() const { return events_.size() - next_; }
+
+    /// Cards in the whole trace
+    int cards() const;
+
+private:
+    void take_time(const TraceEvent& event) const;
+
+    std::vector<TraceEvent> events_;
+    size_t next_ = 0;
+    Timing timing_;
+    int exchanges_ = 0;
+    CardDetection detection_;
+    int max_unchained_ = 0;
+    int wtx_ = 0;
+};
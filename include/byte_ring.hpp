@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/// Fixed-capacity byte FIFO for stream parsers.
+///
+/// Bytes are appended at the tail and consumed from the head without moving the
+/// rest, so dropping a parsed frame costs O(1) instead of an erase from the front.
+/// The storage is allocated once; the capacity is rounded up to a power of two.
+class ByteRing {
+public:
+    explicit ByteRing(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        buf_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    size_t size() const { return tail_ - head_; }
+    size_t capacity() const { return buf_.size(); }
+    size_t free() const { return capacity() - size(); }
+    bool empty() const { return head_ == tail_; }
+
+    /// Byte at offset i from the head (i < size())
+    uint8_t operator[](size_t i) const { return buf_[(head_ + i) & mask_]; }
+
+    /// Append n bytes; false (nothing written) if they do not fit
+    bool push(const uint8_t* data, size_t n) {
+        if (n > free()) return false;
+        size_t pos = tail_ & mask_;
+        size_t first = std::min(n, capacity() - pos);
+        std::memcpy(buf_.data() + pos, data, first);
+        std::memcpy(buf_.data(), data + first, n - first);
+        tail_ += n;
+        return true;
+    }
+
+    /// Copy n bytes starting at offset from the head into out (offset + n <= size())
+    void copy_out(size_t offset, size_t n, uint8_t* out) const {
+        size_t pos = (head_ + offset) & mask_;
+        size_t first = std::min(n, capacity() - pos);
+        std::memcpy(out, buf_.data() + pos, first);
+        std::memcpy(out + first, buf_.data(), n - first);
+    }
+
+    /// Drop n bytes from the head (clamped to size())
+    void consume(size_t n) { head_ += std::min(n, size()); }
+
+    void clear() { head_ = tail_ = 0; }
+
+private:
+    std::vector<uint8_t> buf_;
+    size_t mask_ = 0;
+    size_t head_ = 0;  // Monotonic; masked on access
+    size_t tail_ = 0;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "nfc_transport.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+/// Paces the polls of one wait_for_card and measures how the card was found.
+/// The idle time carries over between waits, so a reader that has seen no card
+/// for a while keeps polling slowly until one shows up.
+class CardPoller {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void configure(const PollSettings& settings) {
+        settings_ = settings;
+        interval_ = settings.interval;
+    }
+    const PollSettings& settings() const { return settings_; }
+
+    /// The reader was (re)opened: it is not idle yet
+    void reset() {
+        last_card_ = Clock::now();
+        interval_ = settings_.interval;
+    }
+
+    /// Start of a wait_for_card
+    void begin() {
+        first_ = Clock::now();
+        polls_ = 0;
+    }
+
+    /// Start of one poll
+    void poll() {
+        polls_++;
+        poll_start_ = Clock::now();
+    }
+
+    /// The card answered the current poll; activation starts now
+    void answered() { answered_ = Clock::now(); }
+
+    /// The card is ready for APDUs
+    void activated() {
+        auto now = Clock::now();
+        last_.polls = polls_;
+        last_.cycle_ms = polls_ > 1 ? ms(answered_ - first_) / (polls_ - 1) : ms(answered_ - poll_start_);
+        last_.activation_ms = ms(now - answered_);
+        last_card_ = now;
+        interval_ = settings_.interval;
+    }
+
+    /// Sleep until the next poll is due. False if it would start after `deadline`.
+    bool wait_next(Clock::time_point deadline) {
+        auto now = Clock::now();
+        if (settings_.idle_interval > settings_.interval && now - last_card_ >= settings_.idle_after) {
+            interval_ = std::min<std::chrono::milliseconds>(settings_.idle_interval, interval_ * 2);
+        }
+        auto next = poll_start_ + interval_;
+        if (next >= deadline) return false;
+        std::this_thread::sleep_until(next);
+        return true;
+    }
+
+    const CardDetection& last() const { return last_; }
+
+private:
+    static double ms(Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+    PollSettings settings_;
+    std::chrono::milliseconds interval_{settings_.interval};
+    Clock::time_point last_card_ = Clock::now();
+    Clock::time_point first_, poll_start_, answered_;
+    int polls_ = 0;
+    CardDetection last_;
+};
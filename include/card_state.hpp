@@ -0,0 +1,35 @@
+#pragma once
+
+#include "protocol.hpp"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Host-side record of the framebuffer each card last displayed, keyed by serial number.
+///
+/// Kept in memory and mirrored to `<dir>/<serial>.fb`. A missing or stale record
+/// only costs a full upload, so it lives with the cache data.
+class CardStateStore {
+public:
+    /// `dir` empty: memory only
+    explicit CardStateStore(std::string dir);
+
+    /// Last packed framebuffer shown by this card, or false if unknown or the
+    /// stored geometry no longer matches the card
+    bool load(const DeviceInfo& device_info, std::vector<uint8_t>& packed);
+
+    /// Record what the card now displays (call after a successful refresh)
+    void save(const DeviceInfo& device_info, const std::vector<uint8_t>& packed);
+
+    /// Drop the record, e.g. when the card's contents became unknown
+    void forget(const std::string& serial_number);
+
+private:
+    std::string path_for(const std::string& serial_number) const;
+
+    std::string dir_;
+    std::mutex mutex_;
+    std::map<std::string, std::vector<uint8_t>> memory_;  // Serialized records
+};
@@ -3,33 +3,129 @@
 #include <cstdint>
 #include <vector>
 #include <array>
+#include <memory>
+#include <string>
+#include "framebuffer.hpp"
+#include "quantizer.hpp"
+#include "resample.hpp"
+#include "thread_pool.hpp"
 
-/// RGB color
-struct Color {
-    int r, g, b;
-};
+/// Decoded image that yields canvas-size RGB rows top to bottom: composited onto
+/// the background color, resized and placed per resize mode. Only the decoded
+/// source is held; no full-size intermediate buffers are built.
+class ImageRowSource {
+public:
+    ImageRowSource(const char* path, int target_w, int target_h,
+                   Color bg_color, const std::string& resize_mode = "fit",
+                   ResampleFilter filter = ResampleFilter::Bilinear);
+    /// Decode from an encoded image (PNG, JPEG, ...) held in memory
+    ImageRowSource(const uint8_t* encoded, size_t size, int target_w, int target_h,
+                   Color bg_color, const std::string& resize_mode = "fit",
+                   ResampleFilter filter = ResampleFilter::Bilinear);
+    ~ImageRowSource();
+    ImageRowSource(const ImageRowSource&) = delete;
+    ImageRowSource& operator=(const ImageRowSource&) = delete;
+
+    int width() const { return target_w_; }
+    int height() const { return target_h_; }
+
+    /// Write the next canvas row as RGB (width * 3 bytes)
+    void next_row(uint8_t* rgb);
 
-/// 4-color palette: black, white, yellow, red
-static const std::array<Color, 4> PALETTE_4COLOR = {{
-    {0, 0, 0},       // 0: black
-    {255, 255, 255},  // 1: white
-    {255, 255, 0},    // 2: yellow
-    {255, 0, 0},      // 3: red
-}};
+private:
+    void init(const std::string& resize_mode);
+    void fill_background(uint8_t* rgb, int x0, int x1) const;
+    void nearest_row(int ry, uint8_t* rgb);
+    void filtered_row(int ry, uint8_t* rgb);
+    const float* filtered_source_row(int sy);
+
+    uint8_t* data_ = nullptr;   // Decoded RGBA source
+    int src_w_ = 0, src_h_ = 0;
+    int target_w_, target_h_;
+    int new_w_ = 0, new_h_ = 0;
+    int off_x_ = 0, off_y_ = 0;
+    Color bg_;
+    ResampleFilter filter_;
+    std::vector<int> src_x_;    // Source column per canvas column, -1 for background
+    int y_ = 0;
+
+    // Filtered path: only resized columns [vis_x0_, vis_x1_) land on the canvas
+    int vis_x0_ = 0, vis_x1_ = 0;
+    ResampleWeights weights_x_, weights_y_;
+    std::vector<float> premul_;     // Premultiplied source row
+    std::vector<float> ring_;       // Horizontally filtered rows, one slot per vertical tap
+    std::vector<int> ring_row_;     // Source row held by each ring slot (-1: empty)
+    std::vector<const float*> window_;  // Ring rows feeding the current output row
+    std::vector<float> column_;     // Vertically filtered output row
+};
 
 /// Load an image file and resize/fit to target dimensions with background color
 /// Returns pixel data as RGB (w * h * 3)
 std::vector<uint8_t> load_and_resize_image(const char* path,
                                             int target_w, int target_h,
                                             Color bg_color,
-                                            const std::string& resize_mode = "fit");
+                                            const std::string& resize_mode = "fit",
+                                            ResampleFilter filter = ResampleFilter::Bilinear);
+
+/// Apply Atkinson dithering to an RGB image, producing an indexed framebuffer.
+/// With a pool, rows run as a wavefront across threads; output equals the serial result.
+Framebuffer dither_atkinson(const std::vector<uint8_t>& rgb,
+                            int width, int height,
+                            const PaletteQuantizer& quantizer = default_quantizer(),
+                            ThreadPool* pool = &ThreadPool::shared());
 
-/// Apply Atkinson dithering to an RGB image, producing a 2D color index array
-std::vector<std::vector<int>> dither_atkinson(const std::vector<uint8_t>& rgb,
-                                               int width, int height,
-                                               const std::array<Color, 4>& palette = PALETTE_4COLOR);
+/// Apply Floyd–Steinberg dithering; wavefront-parallel like dither_atkinson
+Framebuffer dither_floyd_steinberg(const std::vector<uint8_t>& rgb,
+                                   int width, int height,
+                                   const PaletteQuantizer& quantizer = default_quantizer(),
+                                   ThreadPool* pool = &ThreadPool::shared());
 
 /// Nearest-color quantization (no dithering)
-std::vector<std::vector<int>> dither_none(const std::vector<uint8_t>& rgb,
-                                           int width, int height,
-                                           const std::array<Color, 4>& palette = PALETTE_4COLOR);
+Framebuffer dither_none(const std::vector<uint8_t>& rgb,
+                        int width, int height,
+                        const PaletteQuantizer& quantizer = default_quantizer());
+
+/// Ordered dithering with an 8x8 Bayer matrix; row tiles run in parallel on `pool`
+/// (nullptr: calling thread only)
+Framebuffer dither_bayer(const std::vector<uint8_t>& rgb,
+                         int width, int height,
+                         const PaletteQuantizer& quantizer = default_quantizer(),
+                         ThreadPool* pool = &ThreadPool::shared());
+
+/// Ordered dithering with a 64x64 void-and-cluster blue-noise mask; row tiles run
+/// in parallel on `pool` (nullptr: calling thread only)
+Framebuffer dither_bluenoise(const std::vector<uint8_t>& rgb,
+                             int width, int height,
+                             const PaletteQuantizer& quantizer = default_quantizer(),
+                             ThreadPool* pool = &ThreadPool::shared());
+
+/// Incremental ditherer: consumes RGB rows top to bottom and keeps only the
+/// error rows it still needs
+class RowDitherer {
+public:
+    explicit RowDitherer(int width) : width_(width) {}
+    virtual ~RowDitherer() = default;
+
+    int width() const { return width_; }
+
+    /// Quantize the next RGB row (width * 3 bytes) into palette indices
+    virtual void dither_row(const uint8_t* rgb, uint8_t* out) = 0;
+
+    /// Quantize the next `rows` contiguous RGB rows; `out` rows are `out_stride` apart
+    virtual void dither_rows(const uint8_t* rgb, int rows, uint8_t* out, int out_stride);
+
+protected:
+    int width_;
+};
+
+/// Create a row ditherer by name: "atkinson", "floyd-steinberg", "none", "bayer"
+/// or "bluenoise". With a `pool`, bands of rows are dithered in parallel
+/// (wavefront for error diffusion, tiles for ordered methods).
+std::unique_ptr<RowDitherer> make_row_ditherer(const std::string& method, int width,
+                                               const PaletteQuantizer& quantizer = default_quantizer(),
+                                               ThreadPool* pool = nullptr);
+
+/// Ordered row ditherer ("bayer" or "bluenoise")
+std::unique_ptr<RowDitherer> make_ordered_ditherer(const std::string& method, int width,
+                                                   const PaletteQuantizer& quantizer,
+                                                   ThreadPool* pool);
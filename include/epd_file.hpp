@@ -0,0 +1,78 @@
+#pragma once
+
+#include "apdu_cache.hpp"
+#include "pipeline.hpp"
+#include "protocol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// What an .epd file was compiled for
+struct EpdHeader {
+    int width = 0;              // Panel geometry as the card reports it
+    int height = 0;
+    int bits_per_pixel = 0;
+    int rows_per_block = 0;
+    int max_fragment_data = 0;  // Image payload per F0D3 APDU
+    uint64_t content_hash = 0;  // render_cache_key of the source image, options and panel
+    size_t packed_size = 0;
+    int blocks = 0;
+    size_t fragments = 0;
+};
+
+/// Render and encode an image for one panel and write it as a precompiled upload
+/// image (.epd): a header with the panel constraints and a content hash, the
+/// packed framebuffer, and every image-data APDU ready to send. Throws on errors.
+EpdHeader compile_epd(const char* image_path, const std::string& epd_path,
+                      const DeviceInfo& device_info, const RenderOptions& options = RenderOptions());
+
+/// Open an .epd file, check it against the card and read it whole, for callers that
+/// need every block at once (e.g. --diff); throws if it was compiled for another card
+std::shared_ptr<const EncodedImage> load_epd(const char* path, const DeviceInfo& device_info);
+
+/// True if the file at `path` starts like an .epd file
+bool is_epd_file(const char* path);
+
+/// Read-only memory mapping of an .epd file. Opening it checks only the header
+/// and its table of blocks; each block is checked when it is read, so sending
+/// touches every page once and needs no decode, dither or compression.
+class EpdFile {
+public:
+    explicit EpdFile(const std::string& path);
+    ~EpdFile();
+    EpdFile(const EpdFile&) = delete;
+    EpdFile& operator=(const EpdFile&) = delete;
+
+    const EpdHeader& header() const { return header_; }
+
+    /// Why this file cannot be sent to the card, or empty if it can
+    std::string mismatch(const DeviceInfo& device_info) const;
+
+    /// Throw if mismatch() is not empty
+    void check(const DeviceInfo& device_info) const;
+
+    /// Image-data APDUs of one block, parsed from the mapping
+    std::vector<Apdu> block(int index) const;
+
+    /// Packed framebuffer the blocks were encoded from
+    std::vector<uint8_t> packed() const;
+
+private:
+    struct Extent {
+        size_t offset = 0;
+        size_t size = 0;
+        uint64_t checksum = 0;
+    };
+
+    const uint8_t* verified(const Extent& extent, const char* what) const;
+
+    std::string path_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    EpdHeader header_;
+    Extent packed_;
+    std::vector<Extent> blocks_;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "apdu_cache.hpp"
+#include "card_state.hpp"
+#include "nfc_transport.hpp"
+#include "pacing.hpp"
+#include "pipeline.hpp"
+#include "work_stealing_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class NfcEinkCard;
+
+/// One image for the next card presented to any reader
+struct FleetJob {
+    std::string image_path;
+};
+
+/// Outcome of one job
+struct FleetResult {
+    std::string image_path;
+    std::string reader_id;        // Reader of the last attempt
+    std::string serial_number;    // Card of the last attempt
+    bool ok = false;
+    std::string error;            // Last failure, if any
+    int attempts = 0;
+    double ms = 0.0;              // Upload + refresh time of the last attempt
+};
+
+/// Shared state and policy of a fleet run
+struct FleetOptions {
+    RenderOptions render;
+    ApduCache* cache = nullptr;             // Shared by all readers (thread-safe)
+    CardStateStore* card_state = nullptr;   // Updated after each upload, like a single run
+    PacingStore* pacing = nullptr;          // Learned fragment delays
+    RefreshTimeStore* refresh_times = nullptr;  // Refresh durations, to time the polls
+    std::chrono::milliseconds card_poll{500};          // Per wait for a card
+    std::chrono::milliseconds hotplug_interval{2000};  // Between reader enumerations
+    int max_attempts = 3;                   // Per job; a failed job goes to the next card
+    bool verbose = true;                    // One line per reader event on std::cout
+};
+
+/// Drives every attached reader at once: one worker thread per reader takes jobs
+/// from a work-stealing queue and uploads each to the next card presented to it.
+///
+/// Readers are enumerated again every hotplug_interval: new ones get a worker,
+/// and a worker whose reader fails (e.g. unplugged) stops, leaving its queued jobs
+/// to the others. A card is served once per visit: it must leave the reader
+/// before that reader takes another job.
+class FleetScheduler {
+public:
+    using ReaderLister = std::function<std::vector<std::string>()>;
+    using TransportFactory = std::function<std::unique_ptr<NfcTransport>(const std::string& reader_id)>;
+
+    FleetScheduler(ReaderLister list_readers, TransportFactory open_reader,
+                   FleetOptions options = FleetOptions());
+    ~FleetScheduler();
+    FleetScheduler(const FleetScheduler&) = delete;
+    FleetScheduler& operator=(const FleetScheduler&) = delete;
+
+    /// Queue a job (before run)
+    void add_job(FleetJob job);
+
+    /// Serve cards until every job succeeded or ran out of attempts.
+    /// Returns one result per job, in the order they were added.
+    std::vector<FleetResult> run();
+
+    /// Readers that served at least one card, with their card counts
+    std::map<std::string, int> cards_per_reader() const;
+
+private:
+    struct Task {
+        size_t index;
+        FleetJob job;
+    };
+
+    struct Worker {
+        std::string reader_id;
+        size_t lane;
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
+    void discover();
+    void serve(Worker& worker);
+    bool upload(NfcEinkCard& card, Task& task, const Worker& worker);
+    void prepare_next(const Worker& worker, const DeviceInfo& device_info);
+    void finish();
+    void log(const std::string& reader_id, const std::string& message);
+
+    ReaderLister list_readers_;
+    TransportFactory open_reader_;
+    FleetOptions options_;
+
+    std::vector<Task> pending_;           // Jobs added before run()
+    WorkStealingQueue<Task> queue_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    mutable std::mutex mutex_;            // Guards results_, served_ and wakes run()
+    std::condition_variable changed_;
+    std::vector<FleetResult> results_;
+    std::map<std::string, int> served_;
+    std::atomic<size_t> remaining_{0};
+    std::mutex log_mutex_;
+};
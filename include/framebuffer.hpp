@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Contiguous indexed framebuffer: one palette index per pixel (uint8_t),
+/// rows padded to `stride()` bytes in a single allocation
+class Framebuffer {
+public:
+    /// Row alignment in bytes (keeps rows friendly to vector loads)
+    static const int ROW_ALIGN = 16;
+
+    Framebuffer() = default;
+    Framebuffer(int width, int height, uint8_t fill = 0)
+        : width_(width), height_(height),
+          stride_((width + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN),
+          data_((size_t)stride_ * height, fill) {}
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int stride() const { return stride_; }
+    bool empty() const { return width_ == 0 || height_ == 0; }
+
+    uint8_t* row(int y) { return data_.data() + (size_t)y * stride_; }
+    const uint8_t* row(int y) const { return data_.data() + (size_t)y * stride_; }
+
+    uint8_t& at(int x, int y) { return row(y)[x]; }
+    uint8_t at(int x, int y) const { return row(y)[x]; }
+
+    void fill(uint8_t index) { std::fill(data_.begin(), data_.end(), index); }
+
+    uint8_t* data() { return data_.data(); }
+    const uint8_t* data() const { return data_.data(); }
+    size_t size_bytes() const { return data_.size(); }
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    int stride_ = 0;
+    std::vector<uint8_t> data_;
+};
@@ -1,25 +1,124 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 #include <vector>
+#include "framebuffer.hpp"
 #include "protocol.hpp"
+#include "thread_pool.hpp"
 
-/// Pack a single row of color indices into bytes (right-to-left byte order)
-std::vector<uint8_t> pack_row(const std::vector<int>& pixels, int bits_per_pixel = 2);
+/// Pack a single row of color indices into `out` (width / pixels-per-byte bytes,
+/// right-to-left byte order)
+void pack_row(const uint8_t* pixels, int width, int bits_per_pixel, uint8_t* out);
 
 /// Pack a full screen of pixels into bytes
-std::vector<uint8_t> pack_pixels(const std::vector<std::vector<int>>& pixels, int bits_per_pixel = 2);
+std::vector<uint8_t> pack_pixels(const Framebuffer& pixels, int bits_per_pixel = 2);
+
+/// Rotate a framebuffer 90 degrees clockwise: (W x H) -> (H x W)
+Framebuffer rotate_cw90(const Framebuffer& pixels);
+
+/// Packs panel rows straight into the card framebuffer layout, applying the
+/// 90° CW rotation of rotated panels on the fly
+class FramebufferPacker {
+public:
+    explicit FramebufferPacker(const DeviceInfo& device_info);
+
+    /// Pack row `y` of the panel image (device_info.width indices)
+    void write_row(int y, const uint8_t* indices);
+
+    /// Leading bytes of packed() that are final, assuming rows are written top to
+    /// bottom. Rotated panels spread each row over the whole buffer, so nothing is
+    /// final before the last row.
+    size_t complete_bytes() const;
+
+    /// Packed framebuffer (fb_total_bytes)
+    const std::vector<uint8_t>& packed() const { return packed_; }
+    std::vector<uint8_t> take() { return std::move(packed_); }
+
+private:
+    int width_, height_;
+    int bpp_, ppb_;
+    int fb_bytes_per_row_;
+    bool rotated_;
+    int rows_written_ = 0;
+    std::vector<uint8_t> packed_;
+};
+
+/// Pack a panel-size framebuffer into the card layout (rotating if needed)
+std::vector<uint8_t> pack_framebuffer(const Framebuffer& pixels, const DeviceInfo& device_info);
 
 /// Split packed data into blocks
 std::vector<std::vector<uint8_t>> split_blocks(const std::vector<uint8_t>& packed,
                                                 const std::vector<int>& block_sizes);
 
-/// Compress a block using LZO1X-1
-std::vector<uint8_t> compress_block(const std::vector<uint8_t>& block);
+/// LZO1X encoder effort. Every level emits plain LZO1X streams, which the card's
+/// decoder reads; they differ only in how hard the encoder looks for matches.
+enum class LzoLevel {
+    Fast,      // lzo1x_1: fastest, largest output
+    Best,      // lzo1x_999 at level 9
+    Smallest,  // lzo1x_1 and lzo1x_999 at levels 7 and 9; keeps the smallest per block
+    Auto,      // Chosen per image by choose_lzo_level
+};
+
+/// "fast" | "best" | "smallest" | "auto"; throws on anything else
+LzoLevel parse_lzo_level(const std::string& name);
+const char* lzo_level_name(LzoLevel level);
+
+/// Compression settings and the costs LzoLevel::Auto weighs against each other
+struct CompressionOptions {
+    LzoLevel level = LzoLevel::Auto;
+    double rf_us_per_byte = 85.0;     // 106 kbps ISO14443A: 9 bit-times per byte
+    double per_fragment_us = 2500.0;  // Turnaround of one image-data APDU
+    double cpu_budget_ms = 100.0;     // Modelled host compression time allowed per image (0: no limit)
+};
+
+/// Resolve LzoLevel::Auto for one image of `image_bytes`: compress `sample` (one
+/// block of it) at every fixed level whose modelled host time for the whole image
+/// fits the budget, extrapolate the RF time, and return the level with the least
+/// total. Host time comes from a fixed cost per byte, not a clock, so the result
+/// depends only on the data and options. Fixed levels are returned as they are.
+LzoLevel choose_lzo_level(const uint8_t* sample, size_t size, size_t image_bytes,
+                          const CompressionOptions& options, int max_fragment_data = 250);
+
+/// Resolve LzoLevel::Auto for a packed framebuffer of `packed_size` bytes. Every
+/// encoding path uses this rule, so an image gets the same level (and the same cached
+/// bytes) however it was encoded: the sample is block 0, the only block a pipelined
+/// upload has rendered when it must decide.
+LzoLevel resolve_lzo_level(const uint8_t* packed, size_t packed_size, const DeviceInfo& device_info,
+                           const CompressionOptions& options);
+
+/// Compress a block with LZO1X (Auto: as Fast). Thread-safe; each thread reuses its
+/// own work memory. `fast_size`, if set, receives what lzo1x_1 makes of the block.
+std::vector<uint8_t> compress_block(const std::vector<uint8_t>& block, LzoLevel level = LzoLevel::Fast);
+std::vector<uint8_t> compress_block(const uint8_t* data, size_t size, LzoLevel level = LzoLevel::Fast);
+std::vector<uint8_t> compress_block(const uint8_t* data, size_t size, LzoLevel level,
+                                    size_t* fast_size);
+
+/// Split compressed data into fragments of at most max_fragment_data bytes (itself at most 250)
+std::vector<std::vector<uint8_t>> make_fragments(const std::vector<uint8_t>& compressed,
+                                                  int max_fragment_data = 250);
+
+/// Indices of the blocks (see DeviceInfo::block_sizes) whose bytes differ between two
+/// packed framebuffers of the same card; every block if the sizes disagree
+std::vector<int> changed_blocks(const std::vector<uint8_t>& previous,
+                                const std::vector<uint8_t>& packed,
+                                const DeviceInfo& device_info);
+
+/// Compress one block and split it into its image-data APDUs. `fast_fragments`, if
+/// set, receives how many lzo1x_1 would have needed (to report what a level saves).
+std::vector<Apdu> encode_block(const uint8_t* data, size_t size, int block_no,
+                               int max_fragment_data = 250, LzoLevel level = LzoLevel::Fast,
+                               size_t* fast_fragments = nullptr);
 
-/// Split compressed data into fragments (max 250 bytes each)
-std::vector<std::vector<uint8_t>> make_fragments(const std::vector<uint8_t>& compressed);
+/// Encode a packed framebuffer into APDU commands, grouped by block.
+/// With a pool, blocks are compressed concurrently; the result does not depend on it.
+/// LzoLevel::Auto is resolved once, by resolve_lzo_level.
+std::vector<std::vector<Apdu>> encode_packed(const std::vector<uint8_t>& packed,
+                                              const DeviceInfo& device_info,
+                                              ThreadPool* pool = &ThreadPool::shared(),
+                                              const CompressionOptions& compression = {LzoLevel::Fast});
 
 /// Encode a full image into APDU commands
-std::vector<std::vector<Apdu>> encode_image(const std::vector<std::vector<int>>& pixels,
-                                             const DeviceInfo& device_info);
+std::vector<std::vector<Apdu>> encode_image(const Framebuffer& pixels,
+                                             const DeviceInfo& device_info,
+                                             ThreadPool* pool = &ThreadPool::shared());
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "apdu_cache.hpp"
+#include "card_state.hpp"
+#include "nfc_transport.hpp"
+#include "pacing.hpp"
+#include "pipeline.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+
+class NfcEinkCard;
+
+/// Which image each card gets, by serial number.
+///
+/// Read from a text file with one "<serial> <image path>" per line; '#' starts a
+/// comment and the serial "*" matches every card without a line of its own.
+/// Relative image paths are taken from the file's directory. The file is read
+/// again when it changes, so jobs can be added while a kiosk runs.
+class KioskJobs {
+public:
+    /// `path` empty: no file, only the default image
+    explicit KioskJobs(std::string path = "", std::string default_image = "");
+
+    /// Image for this card, or empty if there is none. Re-reads the file first if
+    /// it changed; a file that no longer parses keeps the previous jobs (and throws).
+    std::string lookup(const std::string& serial_number);
+
+    /// Image for this card from the jobs loaded so far, or empty; never reads the file
+    std::string find(const std::string& serial_number) const;
+
+    /// Cards with an image of their own
+    size_t size() const { return jobs_.size(); }
+
+private:
+    void reload();
+
+    std::string path_;
+    std::filesystem::file_time_type mtime_{};
+    std::map<std::string, std::string> jobs_;
+    std::string default_image_;      // From the constructor
+    std::string file_default_;       // From a "*" line
+};
+
+/// Shared state and policy of a kiosk session
+struct KioskOptions {
+    RenderOptions render;
+    ApduCache* cache = nullptr;
+    CardStateStore* card_state = nullptr;
+    PacingStore* pacing = nullptr;
+    RefreshTimeStore* refresh_times = nullptr;       // Refresh durations, to time the polls
+    std::chrono::milliseconds card_poll{500};      // Per wait for a card
+    std::chrono::milliseconds removal_poll{100};   // Between presence checks
+    int max_cards = 0;                             // Stop after this many cards (0: until stop())
+    bool verbose = true;                           // One line per card on std::cout
+};
+
+/// What a kiosk session did
+struct KioskStats {
+    int cards = 0;            // Card visits
+    int uploads = 0;          // Images sent and refreshed
+    int no_job = 0;           // Cards without an image in the job map
+    int failures = 0;
+    double reader_ms = 0.0;   // Opening the reader (once per session)
+    double busy_ms = 0.0;     // From card activation to done, summed over cards
+    int detected = 0;         // Cards whose detection the transport measured (see CardDetection)
+    double poll_cycle_ms = 0.0;   // Summed over those cards
+    double activation_ms = 0.0;   // Summed over those cards
+};
+
+/// Long-running single-reader loop: the reader is opened and configured once,
+/// then each card visit costs only RF activation plus its own upload.
+///
+/// For every card presented: look up its serial number in the job map, upload
+/// and refresh, then wait until the card leaves before serving the next one.
+class KioskSession {
+public:
+    KioskSession(std::unique_ptr<NfcTransport> transport, KioskJobs& jobs,
+                 KioskOptions options = KioskOptions());
+    ~KioskSession();
+    KioskSession(const KioskSession&) = delete;
+    KioskSession& operator=(const KioskSession&) = delete;
+
+    /// Serve cards until stop() or max_cards; reader errors propagate
+    KioskStats run();
+
+    /// Make run() return after the current card (async-signal-safe)
+    void stop() { stop_ = true; }
+
+private:
+    void serve(const std::string& serial);
+    bool upload(const std::string& path);
+    bool wait_for_removal();
+    void log(const std::string& message);
+
+    std::unique_ptr<NfcEinkCard> card_;
+    KioskJobs& jobs_;
+    KioskOptions options_;
+    KioskStats stats_;
+    std::atomic<bool> stop_{false};
+};
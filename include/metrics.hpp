@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Monotonic event or byte count
+class Counter {
+public:
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/// Distribution of observed values over fixed bucket upper bounds.
+/// observe() is lock-free, so it can sit on per-block and per-APDU paths.
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double value);
+
+    /// Consistent-enough copy for reporting (taken while observers may run)
+    struct Snapshot {
+        std::vector<double> bounds;
+        std::vector<uint64_t> counts;  // Per bucket; the last one is +Inf
+        uint64_t count = 0;
+        double sum = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+
+        /// Approximate quantile (0..1), interpolated within its bucket
+        double quantile(double q) const;
+    };
+    Snapshot snapshot() const;
+
+private:
+    std::vector<double> bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<double> sum_{0.0};
+    std::atomic<double> min_{HUGE_VAL};
+    std::atomic<double> max_{0.0};
+};
+
+/// Process-wide registry of named counters and histograms.
+///
+/// Series are identified by a Prometheus metric name plus an optional label set
+/// (e.g. `stage="dither"`). Looking one up takes a lock, so call sites keep the
+/// returned reference in a function-local static; it stays valid for the
+/// lifetime of the process.
+class Metrics {
+public:
+    static Metrics& global();
+
+    Counter& counter(const std::string& name, const std::string& help,
+                     const std::string& labels = "");
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         const std::string& labels = "",
+                         const std::vector<double>& bounds = time_buckets());
+
+    /// Seconds, 50 us to ~100 s in powers of two
+    static std::vector<double> time_buckets();
+
+    /// All series as a JSON object: counters, histograms (count, sum, mean,
+    /// p50/p90/p99, max) and the derived compression ratio
+    std::string json() const;
+
+    /// All series in the Prometheus text exposition format
+    std::string prometheus() const;
+
+    /// Atomically replace `path` with prometheus(), for the node_exporter textfile
+    /// collector. False on I/O errors.
+    bool write_textfile(const std::string& path) const;
+
+private:
+    struct Family {
+        std::string help;
+        std::string type;  // counter | histogram
+        std::map<std::string, std::unique_ptr<Counter>> counters;      // By labels
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;  // By labels
+    };
+
+    Family& family(const std::string& name, const std::string& help, const char* type);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+};
+
+/// send_epaper_stage_seconds{stage="<stage>"}: time per image in one step of the
+/// image pipeline (decode, resize, dither, pack, render), per block for compress
+Histogram& stage_histogram(const std::string& stage);
+
+/// Observes the seconds from construction to destruction into a histogram
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        histogram_.observe(std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start_).count());
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/// Rewrites a Prometheus textfile every `interval` from a background thread, and
+/// once more when destroyed, so a long-running kiosk or fleet can be scraped
+class MetricsTextfileWriter {
+public:
+    MetricsTextfileWriter(std::string path, std::chrono::seconds interval,
+                          Metrics& metrics = Metrics::global());
+    ~MetricsTextfileWriter();
+    MetricsTextfileWriter(const MetricsTextfileWriter&) = delete;
+    MetricsTextfileWriter& operator=(const MetricsTextfileWriter&) = delete;
+
+private:
+    std::string path_;
+    std::chrono::seconds interval_;
+    Metrics& metrics_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::thread thread_;
+};
@@ -1,32 +1,115 @@
 #pragma once
 
+#include "bounded_queue.hpp"
+#include "framebuffer.hpp"
 #include "nfc_transport.hpp"
+#include "pacing.hpp"
 #include "protocol.hpp"
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
+#include <ostream>
 #include <vector>
 
+/// How a refresh went
+struct RefreshResult {
+    double ms = 0.0;    // Until a poll saw the refresh done (at most one poll interval late)
+    int polls = 0;      // F0DE polls sent
+};
+
 /// High-level NFC e-ink card manager — transport-agnostic
 class NfcEinkCard {
 public:
     NfcEinkCard();
+    /// Use a specific transport (e.g. the card emulator) instead of the build default
+    explicit NfcEinkCard(std::unique_ptr<NfcTransport> transport);
     ~NfcEinkCard();
 
     /// Connect, authenticate, and read device info
     void connect();
 
+    /// Open the reader without waiting for a card (for serving many cards in turn)
+    void open_reader();
+
+    /// Wait up to `timeout` for a card on an open reader; once one is activated,
+    /// authenticate and read its device info. False if no card showed up.
+    bool wait_for_card(std::chrono::milliseconds timeout);
+
+    /// True while the card from wait_for_card is still on the reader; false once it
+    /// left or if the transport cannot tell (see NfcTransport::card_present)
+    bool card_present() { return transport_->card_present(); }
+
+    /// How the transport found the current card
+    CardDetection last_detection() const { return transport_->last_detection(); }
+
+    /// Suppress progress output (e.g. when several readers run in one process)
+    void set_quiet(bool quiet) { quiet_ = quiet; }
+
     /// Close connection
     void close();
 
     /// Get device information
     const DeviceInfo& device_info() const { return device_info_; }
 
-    /// Send a 2D color-index image to the card
-    void send_image(const std::vector<std::vector<int>>& pixels);
+    /// Send an indexed framebuffer to the card
+    void send_image(const Framebuffer& pixels);
+
+    /// Send a framebuffer already packed in the card layout (see render_packed)
+    void send_packed(const std::vector<uint8_t>& packed);
+
+    /// Send pre-encoded image-data APDUs, grouped by block (see encode_packed / ApduCache)
+    void send_encoded(const std::vector<std::vector<Apdu>>& blocks);
+
+    /// Send blocks as they arrive from a producer (block 0, 1, ... in order) until
+    /// the queue is closed; `block_count` is only used for progress output
+    void send_stream(BoundedQueue<std::vector<Apdu>>& queue, int block_count);
+
+    /// Send blocks 0, 1, ... as `block` returns them, one at a time (e.g. parsed
+    /// straight from a mapped .epd file)
+    void send_generated(int block_count, const std::function<std::vector<Apdu>(int)>& block);
+
+    /// Send only the listed blocks of a pre-encoded image. If the card rejects the
+    /// partial upload (a status word other than busy), falls back to sending every
+    /// block and returns false; link errors and a card that stays busy propagate.
+    bool send_blocks(const std::vector<std::vector<Apdu>>& blocks, const std::vector<int>& indices);
+
+    /// Pacing of image fragments; assign a FragmentPacer to start from a learned delay
+    FragmentPacer& pacer() { return pacer_; }
 
     /// Start refresh and poll until complete
-    void refresh(float timeout = 30.0f, float poll_interval = 0.5f);
+    RefreshResult refresh(float timeout = 30.0f, float poll_interval = 0.5f);
+
+    /// Start a refresh and return at once; a background thread polls the card until it
+    /// is done. With `expected` (see RefreshTimeStore), the first poll waits until
+    /// shortly before that time and later ones come at a twentieth of it, so the
+    /// result is seen within a few percent of the actual duration. Without it, polls
+    /// come every 500 ms as in refresh(). The card must not be used or destroyed
+    /// until the future is ready; the future throws if the refresh times out.
+    std::future<RefreshResult> refresh_async(
+        std::chrono::milliseconds expected = std::chrono::milliseconds(0),
+        std::chrono::milliseconds timeout = std::chrono::seconds(30));
 
 private:
+    /// Authenticate and read device info from the activated card
+    void identify();
+
+    /// Progress output: std::cout, or a sink when quiet
+    std::ostream& out() const;
+
+    /// Poll until the refresh started at `start` is done
+    RefreshResult wait_refresh(std::chrono::steady_clock::time_point start,
+                               std::chrono::milliseconds expected, std::chrono::milliseconds timeout,
+                               std::chrono::milliseconds interval);
+
+    /// send_apdu through the transport, counted and timed in Metrics::global()
+    std::vector<uint8_t> transmit(const Apdu& apdu);
+
+    /// Send one block's fragments, restarting the block from fragment 0 on failure
+    void send_block(const std::vector<Apdu>& block_apdus);
+
     std::unique_ptr<NfcTransport> transport_;
+    FragmentPacer pacer_;
     DeviceInfo device_info_;
+    bool quiet_ = false;
 };
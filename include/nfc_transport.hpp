@@ -1,10 +1,51 @@
 #pragma once
 
 #include "protocol.hpp"
+#include <chrono>
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstdio>
 #include <memory>
+#include <stdexcept>
+
+/// How wait_for_card looks for a card
+struct PollSettings {
+    bool fast = true;                              // Configure RF once and repeat only SENS_REQ;
+                                                   // false redoes the full RF setup every poll
+    std::chrono::milliseconds interval{20};        // Between polls
+    std::chrono::milliseconds idle_interval{200};  // Back-off limit (<= interval: no back-off)
+    std::chrono::milliseconds idle_after{10000};   // Without a card this long, polls slow down
+};
+
+/// How the card of the last successful wait_for_card was found
+struct CardDetection {
+    int polls = 0;               // Polls in that wait, including the one the card answered
+    double cycle_ms = 0.0;       // Average poll period: a card waits up to this long to be seen
+    double activation_ms = 0.0;  // From the card's first answer until it was ready for APDUs
+};
+
+/// The card answered an APDU with a status word other than 9000. Anything else a
+/// transport throws from send_apdu is a link error (timeout, lost card, USB).
+class ApduStatusError : public std::runtime_error {
+public:
+    explicit ApduStatusError(uint16_t status)
+        : std::runtime_error(message(status)), status_(status) {}
+
+    uint16_t status() const { return status_; }
+
+    /// 6F00: the card is still processing the previous fragment; a later resend works
+    bool busy() const { return status_ == 0x6F00; }
+
+private:
+    static std::string message(uint16_t status) {
+        char text[24];
+        std::snprintf(text, sizeof(text), "APDU error: SW=%04x", status);
+        return text;
+    }
+
+    uint16_t status_;
+};
 
 /// Abstract NFC transport interface for e-ink card communication
 class NfcTransport {
@@ -14,13 +55,52 @@ public:
     /// Open NFC device and wait for a card (blocking)
     virtual void open() = 0;
 
+    /// Open the NFC device only; cards are then taken one at a time with wait_for_card.
+    /// The default does nothing and leaves it to wait_for_card.
+    virtual void open_reader() {}
+
+    /// Look for a card for up to `timeout`; true once one is activated and ready for
+    /// APDUs. A card from an earlier call is dropped first. Throws if the reader
+    /// itself fails (e.g. unplugged). The default calls open(), which blocks.
+    virtual bool wait_for_card(std::chrono::milliseconds timeout) {
+        (void)timeout;
+        open();
+        return true;
+    }
+
+    /// Poll pacing for wait_for_card (backends that poll themselves)
+    virtual void set_polling(const PollSettings& settings) { (void)settings; }
+
+    /// Detection figures of the last card found; polls is 0 if the backend does not poll
+    virtual CardDetection last_detection() const { return CardDetection(); }
+
+    /// True while the card activated by wait_for_card still answers (a cheap
+    /// presence check, no APDU). Backends that cannot tell return false.
+    virtual bool card_present() { return false; }
+
     /// Close NFC connection
     virtual void close() = 0;
 
     /// Send APDU and receive response (without status word)
     /// Throws on communication error or non-9000 status (unless allow_error)
     virtual std::vector<uint8_t> send_apdu(const Apdu& apdu) = 0;
+
+    /// Waiting-time extension requests (ISO-DEP S(WTX)) the card sent while
+    /// processing the last APDU. 0 if the backend cannot observe them.
+    virtual int last_apdu_wtx() const { return 0; }
+
+    /// Largest C-APDU that fits in one ISO-DEP I-block with the frame size
+    /// negotiated with the current card; longer APDUs are chained.
+    /// 0 if the backend does not know it.
+    virtual int max_unchained_apdu() const { return 0; }
 };
 
 /// Create the default NFC transport (selected at build time)
 std::unique_ptr<NfcTransport> create_nfc_transport();
+
+/// Create the default transport bound to one reader (see list_nfc_readers);
+/// an empty id picks the first reader found
+std::unique_ptr<NfcTransport> create_nfc_transport(const std::string& reader_id);
+
+/// Readers the build's backend can currently open, by id
+std::vector<std::string> list_nfc_readers();
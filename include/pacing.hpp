@@ -0,0 +1,96 @@
+#pragma once
+
+#include "protocol.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+/// Counters of a FragmentPacer
+struct PacingStats {
+    int fragments = 0;            // Fragments acknowledged
+    int wtx = 0;                  // Fragments the card held off with WTX
+    int failures = 0;             // Fragment exchanges that failed
+    double slept_us = 0.0;        // Idle time inserted between fragments
+};
+
+/// Inter-fragment delay driven by the card's acknowledgements.
+///
+/// Starts at the learned delay (0 for an unknown card). A failed exchange doubles
+/// the delay, a WTX request raises it by half; after a run of clean fragments it
+/// decays by a quarter so the delay settles just above what the card needs.
+class FragmentPacer {
+public:
+    explicit FragmentPacer(std::chrono::microseconds initial = std::chrono::microseconds(0));
+
+    /// Delay to insert before the next fragment
+    std::chrono::microseconds delay() const { return delay_; }
+
+    /// Sleep for the current delay (no-op at 0)
+    void wait();
+
+    /// Acknowledged fragment; `wtx` = WTX requests seen while it was processed
+    void on_success(int wtx);
+
+    /// Failed fragment exchange
+    void on_failure();
+
+    const PacingStats& stats() const { return stats_; }
+
+    /// Idle time a fixed pause of `fixed` after every fragment would have cost, minus
+    /// the idle time actually spent (negative if pacing slept longer)
+    double saved_us(std::chrono::microseconds fixed = std::chrono::milliseconds(10)) const;
+
+private:
+    void set_delay(int64_t us);
+
+    std::chrono::microseconds delay_;
+    int clean_run_ = 0;
+    PacingStats stats_;
+};
+
+/// Learned inter-fragment delays, persisted as text (`serial:<sn> <us>` and
+/// `panel:<w>x<h> <us>` lines). A card with no entry of its own starts from its
+/// panel's value.
+class PacingStore {
+public:
+    /// `path` empty: memory only
+    explicit PacingStore(std::string path);
+
+    std::chrono::microseconds load(const DeviceInfo& device_info);
+    void save(const DeviceInfo& device_info, std::chrono::microseconds delay);
+
+private:
+    void read();
+    void write() const;
+
+    std::string path_;
+    std::mutex mutex_;
+    bool loaded_ = false;
+    std::map<std::string, int64_t> delays_;
+};
+
+/// Learned panel refresh durations, persisted as text (`panel:<w>x<h> <ms>` lines),
+/// used to schedule refresh polls (see NfcEinkCard::refresh_async). Each
+/// observation moves the prediction halfway towards it, which follows slow drift
+/// (e.g. temperature) without jumping on a single outlier.
+class RefreshTimeStore {
+public:
+    /// `path` empty: memory only
+    explicit RefreshTimeStore(std::string path);
+
+    /// Expected refresh duration for this panel; 0 if it was never timed
+    std::chrono::milliseconds predict(const DeviceInfo& device_info);
+
+    /// Record an observed refresh duration
+    void record(const DeviceInfo& device_info, double ms);
+
+private:
+    void read();
+
+    std::string path_;
+    std::mutex mutex_;
+    bool loaded_ = false;
+    std::map<std::string, int64_t> times_;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "apdu_cache.hpp"
+#include "image.hpp"
+#include "protocol.hpp"
+#include "quantizer.hpp"
+#include "resample.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// How a source image is turned into panel pixels
+struct RenderOptions {
+    Color bg_color = {0, 0, 0};
+    std::string resize_mode = "fit";      // fit | cover
+    ResampleFilter filter = ResampleFilter::Bilinear;
+    std::string dither = "atkinson";      // atkinson | floyd-steinberg | none | bayer | bluenoise
+    ColorMetric metric = ColorMetric::Rgb;
+    int threads = 0;                      // Parallel dithering/encoding: 0 = all cores, 1 = serial
+    CompressionOptions compression;       // LZO level (default: chosen per image)
+};
+
+/// Render an image file straight into the card's packed framebuffer.
+/// Rows stream through composite/resize -> dither -> pack in small bands, so only
+/// the decoded source and a band of row buffers are alive at once.
+std::vector<uint8_t> render_packed(const char* path, const DeviceInfo& device_info,
+                                   const RenderOptions& options = RenderOptions());
+
+/// Same, decoding an image file already read into memory
+std::vector<uint8_t> render_packed(const uint8_t* encoded, size_t size, const DeviceInfo& device_info,
+                                   const RenderOptions& options = RenderOptions());
+
+/// Cache key covering everything that determines the APDU stream: the source file
+/// bytes, the render options that affect pixels, the panel geometry and the encoder
+uint64_t render_cache_key(const uint8_t* encoded, size_t size, const RenderOptions& options,
+                          const DeviceInfo& device_info);
+
+class NfcEinkCard;
+class EpdFile;
+
+/// Outcome of render_and_send
+struct PipelinedSend {
+    std::shared_ptr<const EncodedImage> image;  // Null when an .epd file was sent
+    std::shared_ptr<const EpdFile> epd;         // The mapped .epd file that was sent, if any
+    bool cache_hit = false;
+    bool precompiled = false;   // Sent from an .epd file as compiled
+    double first_block_ms = 0.0;  // From the call until the first block was ready to send
+    LzoLevel lzo_level = LzoLevel::Auto;  // Level the blocks were compressed at (Auto: cache hit)
+    size_t fast_fragments = 0;  // Fragments lzo1x_1 would have needed (0: not encoded here)
+
+    /// Packed framebuffer that was sent (read from the .epd file if there was one)
+    std::vector<uint8_t> packed() const;
+};
+
+/// Render, encode and transmit an image file to a connected card, overlapping the
+/// work with RF: a producer thread queues each block's APDUs (bounded queue) as
+/// soon as its framebuffer rows are final, while the calling thread transmits.
+/// Rotated panels only finish their rows at the end, so there the overlap is
+/// limited to compression. A precompiled .epd file is sent as it is, after
+/// checking it was compiled for this card's panel.
+PipelinedSend render_and_send(NfcEinkCard& card, const char* path,
+                              const RenderOptions& options = RenderOptions(),
+                              ApduCache* cache = nullptr);
+
+/// Render and encode an image file; with a cache, a hit skips decode, dither and compression.
+/// An .epd file is loaded as compiled (and must match `device_info`).
+std::shared_ptr<const EncodedImage> render_encoded(const char* path, const DeviceInfo& device_info,
+                                                   const RenderOptions& options = RenderOptions(),
+                                                   ApduCache* cache = nullptr);
+
+/// Same, for an image file already read into memory
+std::shared_ptr<const EncodedImage> render_encoded(const uint8_t* encoded, size_t size,
+                                                   const DeviceInfo& device_info,
+                                                   const RenderOptions& options = RenderOptions(),
+                                                   ApduCache* cache = nullptr);
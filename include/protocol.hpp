@@ -13,6 +13,7 @@ struct DeviceInfo {
     std::string serial_number;
     std::vector<uint8_t> c1;
     std::vector<uint8_t> raw;
+    int max_fragment_data = 250;  // Image payload per F0D3 APDU (see fragment_payload_for)
 
     int num_colors() const { return 1 << bits_per_pixel; }
     int pixels_per_byte() const { return 8 / bits_per_pixel; }
@@ -46,6 +47,27 @@ struct DeviceInfo {
     int num_blocks() const { return (int)block_sizes().size(); }
 };
 
+/// ISO-DEP parameters announced in a card's ATS (ISO/IEC 14443-4)
+struct AtsParams {
+    int fsc = 32;   // Largest frame the card accepts: PCB + INF + CRC (FSCI default 2)
+    int fwi = 4;    // Frame waiting time integer
+    int sfgi = 0;   // Start-up frame guard time integer
+
+    /// INF bytes per I-block (no CID/NAD): longer APDUs must be chained
+    int max_inf() const { return fsc - 3; }
+    /// Frame waiting time: (256 * 16 / fc) * 2^FWI
+    double fwt_us() const;
+    /// Guard time before the first frame after the ATS (0 if SFGI is 0)
+    double sfgt_us() const;
+};
+
+/// Parse an ATS response, starting with its length byte TL.
+/// Missing interface bytes keep their ISO defaults.
+AtsParams parse_ats(const std::vector<uint8_t>& ats);
+
+/// Largest image payload whose F0D3 APDU fits in max_apdu bytes (16 to 250)
+int fragment_payload_for(int max_apdu);
+
 /// APDU command tuple
 struct Apdu {
     uint8_t cla;
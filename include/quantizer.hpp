@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// RGB color
+struct Color {
+    int r, g, b;
+};
+
+/// 4-color palette: black, white, yellow, red
+static const std::array<Color, 4> PALETTE_4COLOR = {{
+    {0, 0, 0},       // 0: black
+    {255, 255, 255},  // 1: white
+    {255, 255, 0},    // 2: yellow
+    {255, 0, 0},      // 3: red
+}};
+
+/// Distance used to match a pixel to the nearest palette entry
+enum class ColorMetric {
+    Rgb,  // Squared Euclidean distance in sRGB
+    Lab,  // Squared Euclidean distance in CIELAB (D65), perceptual
+};
+
+/// Parse "rgb" / "lab"
+ColorMetric parse_color_metric(const std::string& name);
+
+/// Nearest-palette-color lookup backed by a precomputed 3D table.
+///
+/// RGB space is split into 32^3 cells. A cell whose 27 sample points (corners,
+/// edge midpoints, face centers, center) all map to the same entry stores that
+/// entry; the cells along palette boundaries are refined into an exact per-value
+/// 8^3 sub-table. Lookups cost at most two loads whatever the metric.
+class PaletteQuantizer {
+public:
+    explicit PaletteQuantizer(const std::array<Color, 4>& palette = PALETTE_4COLOR,
+                              ColorMetric metric = ColorMetric::Rgb);
+
+    /// Cached quantizer for a palette/metric pair (built once, thread-safe)
+    static std::shared_ptr<const PaletteQuantizer> shared(const std::array<Color, 4>& palette,
+                                                          ColorMetric metric = ColorMetric::Rgb);
+
+    /// Nearest entry for an in-range (0..255) color
+    int nearest(int r, int g, int b) const {
+        uint16_t cell = lut_[((r >> CELL_SHIFT) << (2 * CELL_BITS)) |
+                             ((g >> CELL_SHIFT) << CELL_BITS) |
+                             (b >> CELL_SHIFT)];
+        if (cell < REFINED) return cell;
+        const int m = (1 << CELL_SHIFT) - 1;
+        return refined_[((size_t)(cell - REFINED) << (3 * CELL_SHIFT)) |
+                        ((r & m) << (2 * CELL_SHIFT)) | ((g & m) << CELL_SHIFT) | (b & m)];
+    }
+
+    /// Nearest entry computed directly (no table)
+    int nearest_exact(int r, int g, int b) const;
+
+    const std::array<Color, 4>& palette() const { return palette_; }
+    ColorMetric metric() const { return metric_; }
+
+    /// Number of cells that needed per-value refinement
+    size_t refined_cells() const { return refined_.size() >> (3 * CELL_SHIFT); }
+
+private:
+    static const int CELL_BITS = 5;               // 32 cells per axis
+    static const int CELL_SHIFT = 8 - CELL_BITS;  // 8 values per cell and axis
+    static const uint16_t REFINED = 0x100;        // lut_ values >= REFINED index refined_
+
+    void build();
+
+    std::array<Color, 4> palette_;
+    ColorMetric metric_;
+    std::array<std::array<float, 3>, 4> palette_lab_;
+    std::vector<uint16_t> lut_;
+    std::vector<uint8_t> refined_;
+};
+
+/// Shared quantizer for PALETTE_4COLOR with RGB distance
+const PaletteQuantizer& default_quantizer();
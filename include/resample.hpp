@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Resampling filter used when resizing source images
+enum class ResampleFilter {
+    Nearest,   // Point sampling (fast, aliases when shrinking)
+    Bilinear,  // Triangle filter, widened by the scale factor when shrinking
+    Lanczos,   // Lanczos-3, widened by the scale factor when shrinking
+    Area,      // Box filter: averages the covered source pixels
+};
+
+/// Parse "nearest" / "bilinear" / "lanczos" / "area"
+ResampleFilter parse_resample_filter(const std::string& name);
+
+/// Precomputed filter taps for one axis.
+/// Output i = sum over k < count[i] of weights[i * max_taps + k] * input[start[i] + k]
+struct ResampleWeights {
+    int max_taps = 0;
+    std::vector<int> start;
+    std::vector<int> count;
+    std::vector<float> weights;  // Normalized to sum 1 per output
+};
+
+/// Build the weight table mapping `in_size` samples onto `out_size` samples
+ResampleWeights compute_resample_weights(ResampleFilter filter, int in_size, int out_size);
+
+/// Convert an RGBA8 row into premultiplied float RGBA: (r*a, g*a, b*a) in 0..255, a in 0..1.
+/// Compositing is linear, so filtering premultiplied pixels and compositing the
+/// result onto the background equals compositing first and filtering afterwards.
+void premultiply_row(const uint8_t* rgba, int width, float* out);
+
+/// Horizontal pass: filter a premultiplied row for outputs [x0, x1) into `out`
+void resample_row(const float* in, const ResampleWeights& weights, int x0, int x1, float* out);
+
+/// Vertical pass: out[j] = sum over k < taps of weights[k] * rows[k][j], for j < n
+void resample_column(const float* const* rows, const float* weights, int taps, int n, float* out);
+
+/// Composite premultiplied RGBA pixels onto a background and store as RGB8
+void composite_row(const float* premul, int width, const float bg[3], uint8_t* rgb);
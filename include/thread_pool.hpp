@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// Fixed-size pool of worker threads
+class ThreadPool {
+public:
+    /// Start `workers` threads (0: run everything on the calling thread)
+    explicit ThreadPool(int workers);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Process-wide pool with one worker per additional hardware thread
+    static ThreadPool& shared();
+
+    int workers() const { return (int)threads_.size(); }
+
+    /// Queue a task; the future yields its result or rethrows its exception
+    template <class F>
+    auto submit(F&& fn) -> std::future<typename std::invoke_result<F>::type> {
+        using R = typename std::invoke_result<F>::type;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        auto future = task->get_future();
+        if (threads_.empty()) {
+            (*task)();
+        } else {
+            enqueue([task] { (*task)(); });
+        }
+        return future;
+    }
+
+    /// Run fn(i) for every i in [0, count) on the workers and the calling thread.
+    /// Blocks until all iterations finished; rethrows the first exception.
+    void parallel_for(int count, const std::function<void(int)>& fn);
+
+private:
+    void enqueue(std::function<void()> job);
+    void worker_loop();
+
+    std::vector<std::thread> threads_;
+    std::queue<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "nfc_transport.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Panel parameters reported by an emulated card in its 00D1 response
+struct EmulatedPanel {
+    int width = 400;            // as reported by the card (296 for the 2.9" panel)
+    int height = 300;
+    int bits_per_pixel = 2;
+    std::string serial_number = "EMU00001";
+    bool partial_updates = true;  // false: after connect or refresh, only accepts blocks
+                                  // 0, 1, 2, ... in order (rejects differential uploads)
+    int fsc = 256;                // ISO-DEP frame size announced in the ATS
+    bool new_card_per_session = false;  // Every wait_for_card after the first presents a
+                                        // blank card with the next serial number (fleet runs)
+    int dwell_ms = 0;             // A card leaves the reader this long after activation
+                                  // (0: it stays until the next wait_for_card)
+};
+
+/// Panel presets: "128x296" / "296x128" (2.9") and "400x300" (4.2")
+EmulatedPanel emulated_panel(const std::string& name);
+
+/// Build the TLV payload a card returns for 00D1 (without status word)
+std::vector<uint8_t> build_device_info_response(const EmulatedPanel& panel);
+
+/// RF latency model of the emulated link
+struct EmulatorTiming {
+    double per_apdu_us = 2500.0;  // Fixed turnaround per frame exchange (reader, FDT, SoF/EoF)
+    double per_byte_us = 85.0;    // 106 kbps ISO14443A: 9 bit-times (data + parity) per byte
+    double refresh_ms = 1500.0;   // Panel refresh duration
+    bool realtime = true;         // Sleep for the modeled latency instead of only accounting it
+    double fragment_busy_us = 0.0; // Card-side processing after each image fragment (wall clock);
+                                   // a fragment sent sooner is held off with WTX...
+    bool busy_fails = false;       // ...or, if set, refused with 6F00 and must be resent
+};
+
+/// Counters accumulated by the emulator since construction
+struct EmulatorStats {
+    int apdus = 0;
+    int frames = 0;               // ISO-DEP I-blocks, counting chained C-APDUs
+    size_t bytes_tx = 0;          // Reader -> card (C-APDU bytes)
+    size_t bytes_rx = 0;          // Card -> reader (R-APDU bytes incl. status word)
+    int blocks_received = 0;
+    int refreshes = 0;
+    int wtx = 0;                  // Fragments held off with WTX (card busy)
+    int busy_errors = 0;          // Fragments refused because the card was busy
+    double modeled_us = 0.0;      // Total modeled RF time
+};
+
+/// In-process emulation of a Santek EZ Sign card — no reader required.
+/// Decompresses every image block into a framebuffer, so uploads can be verified.
+class EmulatorTransport : public NfcTransport {
+public:
+    explicit EmulatorTransport(const EmulatedPanel& panel = EmulatedPanel(),
+                               const EmulatorTiming& timing = EmulatorTiming());
+    ~EmulatorTransport() override;
+
+    void open() override;
+    bool wait_for_card(std::chrono::milliseconds timeout) override;
+    bool card_present() override;
+    void close() override;
+    std::vector<uint8_t> send_apdu(const Apdu& apdu) override;
+    int last_apdu_wtx() const override { return last_wtx_; }
+    int max_unchained_apdu() const override { return panel_.fsc - 3; }
+
+    /// Device info as the host will parse it
+    const DeviceInfo& device_info() const { return device_info_; }
+
+    /// Packed framebuffer as assembled from the received blocks
+    const std::vector<uint8_t>& framebuffer() const { return framebuffer_; }
+
+    /// Set the framebuffer contents, e.g. what the card showed in an earlier run
+    void load_framebuffer(const std::vector<uint8_t>& packed);
+
+    const EmulatorStats& stats() const { return stats_; }
+
+private:
+    /// Handle one APDU; returns response data and sets the status word
+    std::vector<uint8_t> process(const Apdu& apdu, uint16_t& sw);
+    uint16_t receive_fragment(const Apdu& apdu);
+
+    /// Current time on the emulator clock (real or modeled), in microseconds
+    double now_us() const;
+
+    EmulatedPanel panel_;
+    EmulatorTiming timing_;
+    DeviceInfo device_info_;
+    std::vector<int> block_offsets_;
+    std::vector<uint8_t> framebuffer_;
+
+    bool connected_ = false;
+    bool authenticated_ = false;
+    int current_block_ = -1;
+    int next_fragment_ = 0;
+    std::vector<uint8_t> block_data_;
+    int next_block_ = 0;          // Without partial_updates: block the upload must send next
+    double refresh_done_us_ = -1.0;
+    std::chrono::steady_clock::time_point busy_until_;
+    int last_wtx_ = 0;
+    int sessions_ = 0;
+    std::chrono::steady_clock::time_point arrived_;
+
+    std::chrono::steady_clock::time_point start_;
+    EmulatorStats stats_;
+};
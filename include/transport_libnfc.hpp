@@ -1,18 +1,33 @@
 #pragma once
 
+#include "card_poller.hpp"
 #include "nfc_transport.hpp"
+#include <string>
 
 /// libnfc-based NFC transport — works with PN53x and other libnfc-supported readers
 class LibnfcTransport : public NfcTransport {
 public:
-    LibnfcTransport();
+    /// reader_id: a libnfc connstring from list_readers(); empty opens the default device
+    explicit LibnfcTransport(std::string reader_id = "");
     ~LibnfcTransport() override;
 
     void open() override;
+    void open_reader() override;
+    bool wait_for_card(std::chrono::milliseconds timeout) override;
+    bool card_present() override;
+    void set_polling(const PollSettings& settings) override;
+    CardDetection last_detection() const override { return poller_.last(); }
     void close() override;
     std::vector<uint8_t> send_apdu(const Apdu& apdu) override;
+    int max_unchained_apdu() const override { return ats_.max_inf(); }
+
+    /// Connstrings of the devices libnfc can see
+    static std::vector<std::string> list_readers();
 
 private:
+    std::string reader_id_;
     void* nfc_context_ = nullptr;   // nfc_context*
     void* nfc_device_ = nullptr;    // nfc_device*
+    AtsParams ats_;                 // From the selected target's ATS
+    CardPoller poller_;
 };
@@ -1,47 +1,122 @@
 #pragma once
 
 #include "nfc_transport.hpp"
+#include "byte_ring.hpp"
+#include "card_poller.hpp"
+#include "usb_async.hpp"
+#include <cstddef>
 #include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+/// The card did not answer an RF exchange as expected (InCommRF status, no or a
+/// bad activation response). Unlike reader and USB errors, it means "no usable
+/// card" while polling.
+class RfError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 /// RC-S380 (NFC Port-100) transport via libusb — direct USB communication
 class Rcs380Transport : public NfcTransport {
 public:
-    Rcs380Transport();
+    /// async_usb: keep an IN transfer posted on the shared USB event loop and
+    /// complete each command as its response frame arrives. false uses
+    /// blocking bulk transfers polled in 500 ms slices.
+    /// reader_id: one of list_readers(); empty opens the first RC-S380 found.
+    explicit Rcs380Transport(bool async_usb = true, std::string reader_id = "");
     ~Rcs380Transport() override;
 
     void open() override;
+    void open_reader() override;
+    bool wait_for_card(std::chrono::milliseconds timeout) override;
+    bool card_present() override;
+    void set_polling(const PollSettings& settings) override;
+    CardDetection last_detection() const override { return poller_.last(); }
     void close() override;
     std::vector<uint8_t> send_apdu(const Apdu& apdu) override;
+    int last_apdu_wtx() const override { return last_wtx_; }
+    int max_unchained_apdu() const override { return ats_.max_inf(); }
+
+    /// Attached RC-S380 readers by USB bus and port path ("usb:<bus>-<port>[.<port>...]")
+    static std::vector<std::string> list_readers();
 
 private:
+    /// Outcome of a bulk IN read. Timeouts are routine while the reader waits
+    /// on the card, so they are reported here; real USB errors still throw.
+    enum class UsbStatus { Ok, Timeout };
+
     // USB transport
     void usb_open();
-    void usb_write(const std::vector<uint8_t>& data);
-    std::vector<uint8_t> usb_read(int timeout_ms = 5000);
+    void usb_write(const uint8_t* data, size_t size);
+    UsbStatus usb_read(uint8_t* buf, size_t size, size_t& transferred, int timeout_ms = 5000);
 
     // NFC Port-100 framing
-    std::vector<uint8_t> build_frame(const std::vector<uint8_t>& data);
-    std::vector<uint8_t> parse_frame(const std::vector<uint8_t>& frame);
+    void build_frame(uint8_t cmd_code, const uint8_t* data, size_t size);
+    bool parse_frame(uint8_t cmd_code);
 
-    // NFC Port-100 commands
-    std::vector<uint8_t> send_command(uint8_t cmd_code, const std::vector<uint8_t>& cmd_data);
+    // NFC Port-100 commands (the returned data stays valid until the next command)
+    const std::vector<uint8_t>& send_command(uint8_t cmd_code, const uint8_t* data, size_t size);
+    const std::vector<uint8_t>& send_command_async(uint8_t cmd_code);
+    void on_usb_data(const uint8_t* data, size_t size);
+    void on_usb_error(const std::string& message);
+    const std::vector<uint8_t>& send_command(uint8_t cmd_code, const std::vector<uint8_t>& cmd_data) {
+        return send_command(cmd_code, cmd_data.data(), cmd_data.size());
+    }
     void set_command_type(uint8_t type);
     void get_firmware_version();
     void switch_rf(bool on);
     void in_set_rf(const std::vector<uint8_t>& settings);
     void in_set_protocol(const std::vector<uint8_t>& data);
+    void in_comm_rf(const uint8_t* data, size_t size, int timeout_ms, std::vector<uint8_t>& out);
     std::vector<uint8_t> in_comm_rf(const std::vector<uint8_t>& data, int timeout_ms);
 
     // ISO14443 target activation
-    bool sense_and_activate_target();
+    void configure_type_a();
+    bool sense_request(int timeout_ms);
+    bool activate_target();
+    void reset_field();
 
     // ISO-DEP I-block chaining implementation
     std::vector<uint8_t> _send_apdu_impl(const std::vector<uint8_t>& apdu_bytes);
 
+    std::string reader_id_;
     void* usb_ctx_ = nullptr;
     void* usb_handle_ = nullptr;
     uint8_t ep_out_ = 0;
     uint8_t ep_in_ = 0;
     uint8_t block_nr_ = 0;
+    int last_wtx_ = 0;
+    AtsParams ats_;  // Negotiated with the current card (FSD 256 is announced in RATS)
+
+    // Card polling: RF settings are sent once per open reader in fast mode
+    CardPoller poller_;
+    bool rf_configured_ = false;  // in_set_rf and protocol defaults sent
+    bool rf_ready_ = false;       // Field up, no card activated since
+    bool sens_ready_ = false;     // Protocol set up for SENS_REQ
+
+    // Preallocated I/O buffers: once warmed up, a command round trip does not allocate
+    static constexpr size_t RX_CHUNK = 512;
+    std::vector<uint8_t> tx_;        // Outgoing Port-100 frame
+    uint8_t rx_chunk_[RX_CHUNK];     // One bulk IN transfer
+    ByteRing rx_ring_{4096};         // Unparsed bytes from the reader
+    std::vector<uint8_t> rsp_;       // Payload of the last command response
+    std::vector<uint8_t> comm_;      // InCommRF parameters + RF data
+    std::vector<uint8_t> iblock_;    // ISO-DEP block being sent
+    std::vector<uint8_t> rf_rsp_;    // ISO-DEP block received
+
+    // Async USB: rx_ring_, rsp_ and the pending command are filled on the event
+    // thread while a pipe is open, so they are guarded by rx_mutex_
+    bool async_usb_;
+    std::shared_ptr<UsbEventLoop> loop_;
+    std::unique_ptr<UsbAsyncPipe> pipe_;
+    std::mutex rx_mutex_;
+    std::optional<std::promise<void>> pending_;
+    uint8_t pending_cmd_ = 0;
+    std::string usb_error_;
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// libusb context shared by every reader in the process, with one thread
+/// running the event loop for all asynchronous transfers.
+///
+/// The thread starts with the first user and stops when the last reference
+/// goes away; no thread blocks per USB call.
+class UsbEventLoop {
+public:
+    /// The process-wide loop (created on first use)
+    static std::shared_ptr<UsbEventLoop> shared();
+
+    ~UsbEventLoop();
+    UsbEventLoop(const UsbEventLoop&) = delete;
+    UsbEventLoop& operator=(const UsbEventLoop&) = delete;
+
+    /// libusb_context* to open devices on
+    void* context() const { return ctx_; }
+
+private:
+    UsbEventLoop();
+    void run();
+
+    void* ctx_ = nullptr;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+/// Bulk OUT/IN endpoint pair on an open device, driven by async transfers.
+///
+/// An IN transfer is always posted, so bytes from the device are delivered to
+/// the data callback (on the event thread) as soon as they arrive, with no gap
+/// between a write and the following read.
+class UsbAsyncPipe {
+public:
+    using DataCallback = std::function<void(const uint8_t* data, size_t size)>;
+    using ErrorCallback = std::function<void(const std::string& message)>;
+
+    UsbAsyncPipe(std::shared_ptr<UsbEventLoop> loop, void* handle,
+                 uint8_t ep_out, uint8_t ep_in,
+                 DataCallback on_data, ErrorCallback on_error);
+    /// Cancels the IN transfer and waits until no callback can run
+    ~UsbAsyncPipe();
+    UsbAsyncPipe(const UsbAsyncPipe&) = delete;
+    UsbAsyncPipe& operator=(const UsbAsyncPipe&) = delete;
+
+    /// Send data and wait for the OUT transfer to complete. The buffer must stay
+    /// valid until then. Throws std::runtime_error on failure; one write at a time.
+    void write(const uint8_t* data, size_t size, int timeout_ms = 5000);
+
+private:
+    static constexpr size_t IN_SIZE = 512;
+
+    static void in_done(void* transfer);
+    static void out_done(void* transfer);
+    void submit_in();
+
+    std::shared_ptr<UsbEventLoop> loop_;
+    DataCallback on_data_;
+    ErrorCallback on_error_;
+    void* in_ = nullptr;   // libusb_transfer*
+    void* out_ = nullptr;  // libusb_transfer*
+    uint8_t in_buf_[IN_SIZE];
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool in_flight_ = false;
+    bool out_flight_ = false;
+    bool closing_ = false;
+    int out_status_ = 0;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/// Job queue split into one lane per worker. A worker takes from the front of
+/// its own lane and, when that is empty, steals from the back of the fullest
+/// other lane, so idle workers drain whatever the others have left.
+///
+/// Lanes can be added while workers run (e.g. a reader plugged in later) and are
+/// never removed: jobs left in the lane of a worker that stopped are stolen.
+template <class T>
+class WorkStealingQueue {
+public:
+    /// Add a lane; returns its index
+    size_t add_lane() {
+        std::lock_guard<std::mutex> lock(lanes_mutex_);
+        lanes_.push_back(std::make_shared<Lane>());
+        return lanes_.size() - 1;
+    }
+
+    size_t lane_count() const {
+        std::lock_guard<std::mutex> lock(lanes_mutex_);
+        return lanes_.size();
+    }
+
+    /// Append a job to a lane
+    void push(T item, size_t lane) {
+        auto l = get(lane);
+        std::lock_guard<std::mutex> lock(l->mutex);
+        l->items.push_back(std::move(item));
+    }
+
+    /// Put a job at the front of a lane, so its owner takes it next (e.g. a retry)
+    void push_front(T item, size_t lane) {
+        auto l = get(lane);
+        std::lock_guard<std::mutex> lock(l->mutex);
+        l->items.push_front(std::move(item));
+    }
+
+    /// Next job for the owner of `lane`: its own first, otherwise a stolen one
+    std::optional<T> pop(size_t lane) {
+        if (auto item = take(get(lane), true)) return item;
+
+        // Steal from the fullest lane; sizes may change meanwhile, so retry a few times
+        for (int tries = 0; tries < 4; tries++) {
+            std::shared_ptr<Lane> victim;
+            size_t most = 0;
+            for (const auto& l : snapshot()) {
+                std::lock_guard<std::mutex> lock(l->mutex);
+                if (l->items.size() > most) {
+                    most = l->items.size();
+                    victim = l;
+                }
+            }
+            if (!victim) return std::nullopt;
+            if (auto item = take(victim, false)) return item;
+        }
+        return std::nullopt;
+    }
+
+    /// Copy of the job the owner of `lane` would take next from its own lane
+    std::optional<T> peek(size_t lane) const {
+        auto l = get(lane);
+        std::lock_guard<std::mutex> lock(l->mutex);
+        if (l->items.empty()) return std::nullopt;
+        return l->items.front();
+    }
+
+    /// Jobs waiting in all lanes
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& l : snapshot()) {
+            std::lock_guard<std::mutex> lock(l->mutex);
+            total += l->items.size();
+        }
+        return total;
+    }
+
+private:
+    struct Lane {
+        std::mutex mutex;
+        std::deque<T> items;
+    };
+
+    std::shared_ptr<Lane> get(size_t lane) const {
+        std::lock_guard<std::mutex> lock(lanes_mutex_);
+        return lanes_.at(lane);
+    }
+
+    std::vector<std::shared_ptr<Lane>> snapshot() const {
+        std::lock_guard<std::mutex> lock(lanes_mutex_);
+        return lanes_;
+    }
+
+    static std::optional<T> take(const std::shared_ptr<Lane>& l, bool front) {
+        std::lock_guard<std::mutex> lock(l->mutex);
+        if (l->items.empty()) return std::nullopt;
+        T item = std::move(front ? l->items.front() : l->items.back());
+        if (front) {
+            l->items.pop_front();
+        } else {
+            l->items.pop_back();
+        }
+        return item;
+    }
+
+    mutable std::mutex lanes_mutex_;
+    std::vector<std::shared_ptr<Lane>> lanes_;
+};
@@ -1,27 +1,324 @@
 #include "nfc_eink.hpp"
+#include "apdu_trace.hpp"
 #include "dither.hpp"
+#include "epd_file.hpp"
 #include "image.hpp"
+#include "pipeline.hpp"
+#include "card_state.hpp"
+#include "fleet.hpp"
+#include "kiosk.hpp"
+#include "metrics.hpp"
+#include "pacing.hpp"
+#include "transport_emulator.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <csignal>
 #include <iostream>
 #include <string>
+#include <cstdlib>
 #include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <vector>
 
 static void print_usage(const char* prog) {
     std::cout << "Usage: " << prog << " <image_path> [options]\n"
+              << "       " << prog << " --fleet <image_path>... [options]\n"
+              << "       " << prog << " --kiosk [--jobs <file>] [<image_path>] [options]\n"
+              << "       " << prog << " --compile <out.epd> [--panel <size>] <image_path> [options]\n"
               << "       " << prog << " --clear\n"
               << "       " << prog << " --info\n"
+              << "       " << prog << " --list-readers\n"
               << "\n"
               << "NFC E-Paper Image Uploader (Santek EZ Sign 2.9\" 4-color, C++ / libnfc)\n"
               << "\n"
               << "Options:\n"
               << "  --bg <black|white>       Background color (default: black)\n"
-              << "  --dither <atkinson|none>  Dithering algorithm (default: atkinson)\n"
+              << "  --dither <atkinson|floyd-steinberg|none|bayer|bluenoise>  Dithering algorithm (default: atkinson)\n"
               << "  --resize <fit|cover>     Resize mode (default: fit)\n"
+              << "  --filter <nearest|bilinear|lanczos|area>  Resampling filter (default: bilinear)\n"
+              << "  --metric <rgb|lab>       Palette matching distance (default: rgb)\n"
+              << "  --threads <n>            Dithering threads, 0 = all cores (default: 0)\n"
+              << "  --lzo <fast|best|smallest|auto>  LZO1X encoder effort (default: auto, from the costs below)\n"
+              << "  --rf-kbps <n>            With --lzo auto: RF bit rate (default: 106)\n"
+              << "  --cpu-budget <ms>        With --lzo auto: host compression time per image (default: 100)\n"
+              << "  --cache-dir <dir>        Encoded image cache (default: ~/.cache/send_epaper)\n"
+              << "  --cache-size <MB>        Disk space for encoded images; the least recently used go\n"
+              << "                           first (default: 64; 0 = keep them in memory only)\n"
+              << "  --no-cache               Always re-render and re-encode the image\n"
+              << "  --compile <out.epd>      Render, dither and compress now and write the upload as an .epd\n"
+              << "                           file; sending an .epd file skips all image work\n"
+              << "  --panel <128x296|400x300>  With --compile: panel to compile for (default: 128x296)\n"
+              << "  --frame-size <bytes>     With --compile: smallest ISO-DEP frame of the readers that will\n"
+              << "                           send the file (default: 256)\n"
+              << "  --diff                   Send only the blocks that changed since this card's last image\n"
               << "  --clear                  Clear the screen to white\n"
               << "  --info                   Display device information\n"
+              << "  --emulate <128x296|400x300>  Use an in-process emulated card instead of a reader\n"
+              << "  --reader <id>            Use this reader (see --list-readers; default: the first found)\n"
+              << "  --list-readers           List attached readers\n"
+              << "  --fleet                  Serve every attached reader: each image goes to the next card\n"
+              << "                           presented to any reader (one worker per reader, hotplug aware)\n"
+              << "  --readers <n>            With --emulate --fleet: number of emulated readers (default: 4)\n"
+              << "  --kiosk                  Keep the reader open and serve card after card: each card gets\n"
+              << "                           its image from --jobs, or <image_path> if it has none\n"
+              << "  --jobs <file>            With --kiosk: \"<serial> <image_path>\" per line (\"*\" matches\n"
+              << "                           any card); re-read when it changes\n"
+              << "  --cards <n>              With --kiosk: stop after n cards (default: until interrupted)\n"
+              << "  --poll <ms>              Card poll interval (default: 20)\n"
+              << "  --poll-idle <ms>         Slow polling down to this interval after 10 s without a card\n"
+              << "                           (default: 200; 0 = never)\n"
+              << "  --poll-full              Redo the full RF setup on every poll (RC-S380)\n"
+              << "  --record <file>          Record every APDU exchange with the card to a trace file\n"
+              << "                           (with --fleet: one file per reader, <file>.<reader>)\n"
+              << "  --replay <file>          Play a recorded trace back instead of using a reader; card\n"
+              << "                           state, pacing and refresh times are not read or saved\n"
+              << "  --replay-fast            With --replay: skip the recorded card and RF time\n"
+              << "  --stats <json|prometheus>  Print stage timings, APDU round trips and byte counts at exit\n"
+              << "  --metrics-file <path>    Keep a Prometheus textfile with the same metrics up to date\n"
+              << "  --metrics-interval <s>   With --metrics-file: seconds between rewrites (default: 15)\n"
               << "  --help                   Show this help message\n";
 }
 
+// --stats: printed when main returns, whichever way it does
+struct StatsReport {
+    std::string format;
+    ~StatsReport() {
+        if (format == "json") std::cout << Metrics::global().json() << std::flush;
+        if (format == "prometheus") std::cout << Metrics::global().prometheus() << std::flush;
+    }
+};
+
+// --record / --replay
+struct TraceOptions {
+    std::string record;  // Trace file to write
+    std::string replay;  // Trace file to play back instead of a reader
+    TraceReplayTransport::Timing timing = TraceReplayTransport::Timing::Recorded;
+};
+
+static std::unique_ptr<TraceReplayTransport> replay_transport(const TraceOptions& trace) {
+    auto events = load_trace(trace.replay);
+    std::cout << "Replaying " << events.size() << " events from " << trace.replay
+              << (trace.timing == TraceReplayTransport::Timing::Fast ? " (fast)" : "") << std::endl;
+    return std::make_unique<TraceReplayTransport>(std::move(events), trace.timing);
+}
+
+static std::unique_ptr<NfcTransport> recorded(std::unique_ptr<NfcTransport> transport,
+                                              const std::string& path) {
+    if (path.empty()) return transport;
+    return std::make_unique<TraceRecorder>(std::move(transport), path);
+}
+
+// Refresh on the schedule predicted for this panel and learn from the result
+static void refresh_display(NfcEinkCard& card, RefreshTimeStore* refresh_times) {
+    const auto& info = card.device_info();
+    auto expected = refresh_times ? refresh_times->predict(info) : std::chrono::milliseconds(0);
+    auto result = card.refresh_async(expected).get();
+    if (refresh_times) refresh_times->record(info, result.ms);
+    std::cout << "Refresh took " << (int)result.ms << " ms (" << result.polls << " polls";
+    if (expected.count() > 0) std::cout << ", predicted " << expected.count() << " ms";
+    std::cout << ")" << std::endl;
+}
+
+// --fleet: one worker per reader, each image to the next card presented anywhere
+static int run_fleet(const std::vector<std::string>& images, const RenderOptions& render,
+                     const std::string& cache_dir, bool use_cache, uint64_t cache_bytes,
+                     const std::string& emulate_panel, int emulated_readers,
+                     const PollSettings& polling, const std::string& record_path) {
+    std::unique_ptr<ApduCache> cache;
+    std::unique_ptr<CardStateStore> card_state;
+    std::unique_ptr<PacingStore> pacing;
+    std::unique_ptr<RefreshTimeStore> refresh_times;
+    if (use_cache) {
+        cache = std::make_unique<ApduCache>(cache_dir.empty() ? "" : cache_dir + "/apdu", 64, cache_bytes);
+        if (!cache_dir.empty()) {
+            card_state = std::make_unique<CardStateStore>(cache_dir + "/cards");
+            pacing = std::make_unique<PacingStore>(cache_dir + "/pacing.txt");
+            refresh_times = std::make_unique<RefreshTimeStore>(cache_dir + "/refresh.txt");
+        }
+    }
+
+    FleetOptions options;
+    options.render = render;
+    options.cache = cache.get();
+    options.card_state = card_state.get();
+    options.pacing = pacing.get();
+    options.refresh_times = refresh_times.get();
+
+    FleetScheduler::ReaderLister lister = list_nfc_readers;
+    FleetScheduler::TransportFactory factory =
+        [polling](const std::string& id) {
+            auto transport = create_nfc_transport(id);
+            transport->set_polling(polling);
+            return transport;
+        };
+    if (!emulate_panel.empty()) {
+        // Emulated readers, each presenting a fresh card (own serial range) per session
+        lister = [emulated_readers] {
+            std::vector<std::string> ids;
+            for (int i = 0; i < emulated_readers; i++) ids.push_back("emu:" + std::to_string(i));
+            return ids;
+        };
+        factory = [emulate_panel](const std::string& id) -> std::unique_ptr<NfcTransport> {
+            EmulatedPanel panel = emulated_panel(emulate_panel);
+            std::ostringstream serial;
+            serial << "EMU" << std::setw(2) << std::setfill('0') << id.substr(4) << "0001";
+            panel.serial_number = serial.str();
+            panel.new_card_per_session = true;
+            return std::make_unique<EmulatorTransport>(panel);
+        };
+    }
+
+    if (!record_path.empty()) {
+        // One trace per reader, named after its id
+        factory = [factory, record_path](const std::string& id) {
+            std::string suffix = id;
+            for (char& c : suffix) {
+                if (!std::isalnum((unsigned char)c)) c = '_';
+            }
+            return recorded(factory(id), record_path + "." + suffix);
+        };
+    }
+
+    FleetScheduler scheduler(lister, factory, options);
+    for (const auto& path : images) scheduler.add_job({path});
+
+    auto start = std::chrono::steady_clock::now();
+    auto results = scheduler.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int ok = 0;
+    for (const auto& r : results) {
+        if (r.ok) {
+            ok++;
+        } else {
+            std::cerr << "Failed: " << r.image_path << " after " << r.attempts
+                      << " attempt(s): " << r.error << std::endl;
+        }
+    }
+    auto per_reader = scheduler.cards_per_reader();
+    std::cout << "Fleet: " << ok << "/" << results.size() << " cards in " << std::fixed
+              << std::setprecision(1) << seconds << " s (" << ok * 60.0 / std::max(seconds, 0.001)
+              << " cards/min) on " << per_reader.size() << " readers" << std::endl;
+    for (const auto& [id, count] : per_reader) {
+        std::cout << "  " << id << ": " << count << " cards" << std::endl;
+    }
+    return ok == (int)results.size() ? 0 : 1;
+}
+
+// --compile: everything up to the APDUs, done once ahead of time for a panel preset
+static int run_compile(const std::string& image_path, const std::string& epd_path,
+                       const std::string& panel_name, int frame_size, const RenderOptions& render) {
+    if (image_path.empty()) {
+        std::cerr << "Error: --compile needs an image." << std::endl;
+        return 1;
+    }
+    // What a card with this panel reports, over a link with this ISO-DEP frame size
+    EmulatedPanel panel = emulated_panel(panel_name);
+    if (frame_size > 0) panel.fsc = frame_size;
+    EmulatorTransport emulator(panel);
+    DeviceInfo info = emulator.device_info();
+    info.max_fragment_data = fragment_payload_for(emulator.max_unchained_apdu());
+
+    auto start = std::chrono::steady_clock::now();
+    EpdHeader header = compile_epd(image_path.c_str(), epd_path, info, render);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Compiled " << image_path << " for " << header.width << "x" << header.height
+              << " in " << (int)ms << " ms: " << header.blocks << " blocks, " << header.fragments
+              << " fragments -> " << epd_path << std::endl;
+    return 0;
+}
+
+// --kiosk: Ctrl-C lets the current card finish, then prints the summary
+static KioskSession* active_kiosk = nullptr;
+
+static void stop_kiosk(int) {
+    if (active_kiosk) active_kiosk->stop();
+}
+
+static int run_kiosk(const std::string& jobs_path, const std::string& default_image,
+                     int max_cards, const RenderOptions& render, const std::string& cache_dir,
+                     bool use_cache, uint64_t cache_bytes, const std::string& emulate_panel,
+                     const std::string& reader_id,
+                     const PollSettings& polling, const TraceOptions& trace) {
+    if (jobs_path.empty() && default_image.empty()) {
+        std::cerr << "Error: --kiosk needs an image or a --jobs file." << std::endl;
+        return 1;
+    }
+    KioskJobs jobs(jobs_path, default_image);
+    if (!jobs_path.empty()) {
+        std::cout << "Jobs: " << jobs.size() << " cards in " << jobs_path << std::endl;
+    }
+
+    std::unique_ptr<ApduCache> cache;
+    std::unique_ptr<CardStateStore> card_state;
+    std::unique_ptr<PacingStore> pacing;
+    std::unique_ptr<RefreshTimeStore> refresh_times;
+    if (use_cache) {
+        cache = std::make_unique<ApduCache>(cache_dir.empty() ? "" : cache_dir + "/apdu", 64, cache_bytes);
+        // A replayed card is not the real one: what it shows and how it paces stay untouched
+        if (!cache_dir.empty() && trace.replay.empty()) {
+            card_state = std::make_unique<CardStateStore>(cache_dir + "/cards");
+            pacing = std::make_unique<PacingStore>(cache_dir + "/pacing.txt");
+            refresh_times = std::make_unique<RefreshTimeStore>(cache_dir + "/refresh.txt");
+        }
+    }
+
+    KioskOptions options;
+    options.render = render;
+    options.cache = cache.get();
+    options.card_state = card_state.get();
+    options.pacing = pacing.get();
+    options.refresh_times = refresh_times.get();
+    options.max_cards = max_cards;
+
+    std::unique_ptr<NfcTransport> transport;
+    if (!trace.replay.empty()) {
+        auto replay = replay_transport(trace);
+        // Stop at the end of the trace instead of waiting for more cards
+        if (options.max_cards <= 0) options.max_cards = replay->cards();
+        transport = std::move(replay);
+    } else if (!emulate_panel.empty()) {
+        // A stream of taps: a new card every visit, lifted a second after it arrives
+        EmulatedPanel panel = emulated_panel(emulate_panel);
+        panel.new_card_per_session = true;
+        panel.dwell_ms = 1000;
+        transport = std::make_unique<EmulatorTransport>(panel);
+    } else {
+        transport = create_nfc_transport(reader_id);
+        transport->set_polling(polling);
+    }
+
+    KioskSession kiosk(recorded(std::move(transport), trace.record), jobs, options);
+    active_kiosk = &kiosk;
+    std::signal(SIGINT, stop_kiosk);
+    std::signal(SIGTERM, stop_kiosk);
+    KioskStats st;
+    try {
+        st = kiosk.run();
+    } catch (...) {
+        active_kiosk = nullptr;
+        throw;
+    }
+    active_kiosk = nullptr;
+
+    std::cout << "Kiosk: " << st.uploads << "/" << st.cards << " cards updated";
+    if (st.no_job) std::cout << ", " << st.no_job << " without a job";
+    if (st.failures) std::cout << ", " << st.failures << " failed";
+    std::cout << "; reader opened once (" << (int)st.reader_ms << " ms)";
+    if (st.cards) std::cout << ", " << (int)(st.busy_ms / st.cards) << " ms per card";
+    std::cout << std::endl;
+    if (st.detected) {
+        std::cout << "Detection: polled every " << std::fixed << std::setprecision(1)
+                  << st.poll_cycle_ms / st.detected << " ms, activation "
+                  << st.activation_ms / st.detected << " ms (averages over " << st.detected
+                  << " cards)" << std::endl;
+    }
+    return st.failures ? 1 : 0;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         print_usage(argv[0]);
@@ -33,8 +330,34 @@ int main(int argc, char* argv[]) {
     std::string bg_name = "black";
     std::string dither_name = "atkinson";
     std::string resize_mode = "fit";
+    std::string filter_name = "bilinear";
+    std::string metric_name = "rgb";
+    int threads = 0;
+    CompressionOptions compression;
+    std::string lzo_name = "auto";
+    std::string cache_dir = default_cache_dir();
+    bool use_cache = true;
+    uint64_t cache_bytes = ApduCache::DEFAULT_DISK_BYTES;
+    bool differential = false;
     bool do_clear = false;
     bool do_info = false;
+    std::string emulate_panel;
+    std::string compile_path;
+    std::string compile_panel = "128x296";
+    int compile_frame = 0;
+    std::string reader_id;
+    bool list_readers = false;
+    bool fleet = false;
+    int emulated_readers = 4;
+    bool kiosk = false;
+    std::string jobs_path;
+    int max_cards = 0;
+    PollSettings polling;
+    StatsReport stats;
+    TraceOptions trace;
+    std::string metrics_file;
+    int metrics_interval = 15;
+    std::vector<std::string> image_paths;
 
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -51,8 +374,75 @@ int main(int argc, char* argv[]) {
             dither_name = argv[++i];
         } else if (arg == "--resize" && i + 1 < argc) {
             resize_mode = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter_name = argv[++i];
+        } else if (arg == "--metric" && i + 1 < argc) {
+            metric_name = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--lzo" && i + 1 < argc) {
+            lzo_name = argv[++i];
+        } else if (arg == "--rf-kbps" && i + 1 < argc) {
+            // ISO14443A sends 9 bit-times (data + parity) per byte
+            compression.rf_us_per_byte = 9000.0 / std::max(1.0, std::atof(argv[++i]));
+        } else if (arg == "--cpu-budget" && i + 1 < argc) {
+            compression.cpu_budget_ms = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (arg == "--cache-size" && i + 1 < argc) {
+            cache_bytes = (uint64_t)std::max(0, std::atoi(argv[++i])) << 20;
+        } else if (arg == "--no-cache") {
+            use_cache = false;
+        } else if (arg == "--diff") {
+            differential = true;
+        } else if (arg == "--compile" && i + 1 < argc) {
+            compile_path = argv[++i];
+        } else if (arg == "--panel" && i + 1 < argc) {
+            compile_panel = argv[++i];
+        } else if (arg == "--frame-size" && i + 1 < argc) {
+            compile_frame = std::max(16, std::atoi(argv[++i]));
+        } else if (arg == "--emulate" && i + 1 < argc) {
+            emulate_panel = argv[++i];
+        } else if (arg == "--reader" && i + 1 < argc) {
+            reader_id = argv[++i];
+        } else if (arg == "--list-readers") {
+            list_readers = true;
+        } else if (arg == "--fleet") {
+            fleet = true;
+        } else if (arg == "--readers" && i + 1 < argc) {
+            emulated_readers = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--kiosk") {
+            kiosk = true;
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs_path = argv[++i];
+        } else if (arg == "--cards" && i + 1 < argc) {
+            max_cards = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--poll" && i + 1 < argc) {
+            polling.interval = std::chrono::milliseconds(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--poll-idle" && i + 1 < argc) {
+            polling.idle_interval = std::chrono::milliseconds(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--poll-full") {
+            polling.fast = false;
+        } else if (arg == "--record" && i + 1 < argc) {
+            trace.record = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            trace.replay = argv[++i];
+        } else if (arg == "--replay-fast") {
+            trace.timing = TraceReplayTransport::Timing::Fast;
+        } else if (arg == "--stats" && i + 1 < argc) {
+            stats.format = argv[++i];
+            if (stats.format != "json" && stats.format != "prometheus") {
+                std::cerr << "Unknown stats format: " << stats.format << std::endl;
+                stats.format.clear();
+                return 1;
+            }
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            metrics_file = argv[++i];
+        } else if (arg == "--metrics-interval" && i + 1 < argc) {
+            metrics_interval = std::max(1, std::atoi(argv[++i]));
         } else if (arg[0] != '-') {
             image_path = arg;
+            image_paths.push_back(arg);
         } else {
             std::cerr << "Unknown option: " << arg << std::endl;
             print_usage(argv[0]);
@@ -73,11 +463,109 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (image_paths.size() > 1 && !fleet) {
+        std::cerr << "Error: several images need --fleet" << std::endl;
+        return 1;
+    }
+
+    // Rewritten in the background and once more on the way out
+    std::unique_ptr<MetricsTextfileWriter> metrics_writer;
+    if (!metrics_file.empty()) {
+        metrics_writer = std::make_unique<MetricsTextfileWriter>(
+            metrics_file, std::chrono::seconds(metrics_interval));
+    }
+
     try {
-        NfcEinkCard card;
+        if (list_readers) {
+            for (const auto& id : list_nfc_readers()) std::cout << id << std::endl;
+            return 0;
+        }
+
+        RenderOptions options;
+        options.bg_color = bg_color;
+        options.resize_mode = resize_mode;
+        options.filter = parse_resample_filter(filter_name);
+        options.dither = dither_name;
+        options.metric = parse_color_metric(metric_name);
+        options.threads = threads;
+        options.compression = compression;
+        options.compression.level = parse_lzo_level(lzo_name);
+
+        if (!compile_path.empty()) {
+            return run_compile(image_path, compile_path, compile_panel, compile_frame, options);
+        }
+
+        if (kiosk) {
+            return run_kiosk(jobs_path, image_path, max_cards, options,
+                             use_cache ? cache_dir : "", use_cache, cache_bytes, emulate_panel, reader_id,
+                             polling, trace);
+        }
+
+        if (fleet) {
+            if (image_paths.empty()) {
+                std::cerr << "Error: --fleet needs at least one image." << std::endl;
+                return 1;
+            }
+            if (!trace.replay.empty()) {
+                std::cerr << "Error: --replay plays one reader's trace; it cannot drive --fleet." << std::endl;
+                return 1;
+            }
+            return run_fleet(image_paths, options, use_cache ? cache_dir : "", use_cache, cache_bytes,
+                             emulate_panel, emulated_readers, polling, trace.record);
+        }
+
+        // Per-card records (shown image, pacing, refresh time) describe real cards: a
+        // replay neither reads nor writes them
+        const bool card_records = use_cache && !cache_dir.empty() && trace.replay.empty();
+
+        // Last image shown by each card, for --diff. Kept current on every upload.
+        std::unique_ptr<CardStateStore> card_state;
+        if (card_records) {
+            card_state = std::make_unique<CardStateStore>(cache_dir + "/cards");
+        }
+
+        // With --emulate, keep a handle on the emulator to report its counters
+        EmulatorTransport* emulator = nullptr;
+        std::unique_ptr<NfcTransport> transport;
+        if (!trace.replay.empty()) {
+            transport = replay_transport(trace);
+        } else if (!emulate_panel.empty()) {
+            auto emu = std::make_unique<EmulatorTransport>(emulated_panel(emulate_panel));
+            // Like a real card, the emulated one still shows what the previous run sent
+            std::vector<uint8_t> shown;
+            if (card_state && card_state->load(emu->device_info(), shown)) {
+                emu->load_framebuffer(shown);
+            }
+            emulator = emu.get();
+            transport = std::move(emu);
+        } else {
+            transport = create_nfc_transport(reader_id);
+            transport->set_polling(polling);
+        }
+        transport = recorded(std::move(transport), trace.record);
+        NfcTransport* link = transport.get();
+
+        NfcEinkCard card(std::move(transport));
         card.connect();
+        auto detection = link->last_detection();
+        if (detection.polls > 0) {
+            std::cout << "Card found after " << detection.polls << " polls (every "
+                      << std::fixed << std::setprecision(1) << detection.cycle_ms
+                      << " ms), activated in " << detection.activation_ms << " ms" << std::endl;
+        }
 
         const auto& info = card.device_info();
+
+        // Start from the fragment delay learned for this card (or panel) in earlier runs
+        std::unique_ptr<PacingStore> pacing;
+        if (card_records) {
+            pacing = std::make_unique<PacingStore>(cache_dir + "/pacing.txt");
+            card.pacer() = FragmentPacer(pacing->load(info));
+        }
+        std::unique_ptr<RefreshTimeStore> refresh_times;
+        if (card_records) {
+            refresh_times = std::make_unique<RefreshTimeStore>(cache_dir + "/refresh.txt");
+        }
         int w = info.width;
         int h = info.height;
 
@@ -92,10 +580,14 @@ int main(int argc, char* argv[]) {
         if (do_clear) {
             std::cout << "Clearing display..." << std::endl;
             // All white (index 1)
-            std::vector<std::vector<int>> pixels(h, std::vector<int>(w, 1));
-            card.send_image(pixels);
+            Framebuffer pixels(w, h, 1);
+            auto packed = pack_framebuffer(pixels, info);
+            if (card_state) card_state->forget(info.serial_number);
+            card.send_packed(packed);
+            if (pacing) pacing->save(info, card.pacer().delay());
             std::cout << "Refreshing display..." << std::endl;
-            card.refresh();
+            refresh_display(card, refresh_times.get());
+            if (card_state) card_state->save(info, packed);
             std::cout << "Done!" << std::endl;
             return 0;
         }
@@ -109,28 +601,71 @@ int main(int argc, char* argv[]) {
         // Load and process image
         std::cout << "Loading: " << image_path << std::endl;
         std::cout << "Options: bg=" << bg_name << ", dither=" << dither_name
-                  << ", resize=" << resize_mode << std::endl;
+                  << ", resize=" << resize_mode << ", filter=" << filter_name << ", metric=" << metric_name << std::endl;
 
-        auto rgb = load_and_resize_image(image_path.c_str(), w, h, bg_color, resize_mode);
+        std::unique_ptr<ApduCache> cache;
+        if (use_cache) {
+            cache = std::make_unique<ApduCache>(cache_dir.empty() ? "" : cache_dir + "/apdu", 64, cache_bytes);
+        }
+        std::vector<uint8_t> previous;
+        bool known = differential && card_state && card_state->load(info, previous);
 
-        // Dither
-        std::vector<std::vector<int>> pixels;
-        if (dither_name == "atkinson") {
-            pixels = dither_atkinson(rgb, w, h);
-        } else if (dither_name == "none") {
-            pixels = dither_none(rgb, w, h);
+        // The record is dropped before sending: if the upload breaks off, the card's
+        // contents are unknown until the next full upload.
+        std::shared_ptr<const EncodedImage> encoded;
+        PipelinedSend sent;
+        auto send_start = std::chrono::steady_clock::now();
+        if (known) {
+            // Differential: the whole image is needed to find the changed blocks
+            encoded = render_encoded(image_path.c_str(), info, options, cache.get());
+            auto blocks = changed_blocks(previous, encoded->packed, info);
+            if (blocks.empty()) {
+                std::cout << "Card already shows this image; nothing to send" << std::endl;
+                return 0;
+            }
+            if (card_state) card_state->forget(info.serial_number);
+            card.send_blocks(encoded->blocks, blocks);
         } else {
-            std::cerr << "Unknown dither method: " << dither_name << std::endl;
-            return 1;
+            // Blocks go out while later ones are still being rendered and compressed
+            if (card_state) card_state->forget(info.serial_number);
+            sent = render_and_send(card, image_path.c_str(), options, cache.get());
+            std::cout << (sent.precompiled ? "Precompiled" : sent.cache_hit ? "Cache hit" : "Rendered")
+                      << "; first block ready after " << (int)sent.first_block_ms << " ms" << std::endl;
+
+            // Only a fresh encode knows what lzo1x_1 would have made of the image
+            if (!sent.cache_hit && !sent.precompiled) {
+                size_t fragments = sent.image->fragment_count();
+                std::cout << "Compression: " << fragments << " fragments at LZO level "
+                          << lzo_level_name(sent.lzo_level);
+                if (sent.fast_fragments > fragments) {
+                    std::cout << ", " << sent.fast_fragments - fragments << " fewer than lzo1x_1";
+                }
+                std::cout << std::endl;
+            }
         }
+        double send_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - send_start).count();
+        if (pacing) pacing->save(info, card.pacer().delay());
 
-        // Send
-        std::cout << "Sending image..." << std::endl;
-        card.send_image(pixels);
+        const auto& ps = card.pacer().stats();
+        std::cout << "Pacing: " << ps.fragments << " fragments, " << ps.wtx << " WTX, "
+                  << ps.failures << " failures; idle " << (int)(ps.slept_us / 1000) << " ms, saved "
+                  << (int)(card.pacer().saved_us() / 1000) << " ms vs fixed 10 ms pauses (delay now "
+                  << card.pacer().delay().count() << " us)" << std::endl;
         std::cout << "Refreshing display..." << std::endl;
-        card.refresh();
+        refresh_display(card, refresh_times.get());
+        if (card_state) card_state->save(info, known ? encoded->packed : sent.packed());
         std::cout << "Done!" << std::endl;
 
+        if (emulator) {
+            const auto& st = emulator->stats();
+            std::cout << "Emulator: " << st.apdus << " APDUs in " << st.frames << " frames, "
+                      << st.bytes_tx << " bytes sent, " << st.bytes_rx << " bytes received, "
+                      << "modeled RF time " << (int)(st.modeled_us / 1000) << " ms" << std::endl;
+            std::cout << "Upload took " << (int)send_ms << " ms ("
+                      << (int)(st.bytes_tx * 1000.0 / std::max(send_ms, 1.0)) << " B/s)" << std::endl;
+        }
+
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
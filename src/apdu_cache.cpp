@@ -0,0 +1,213 @@
+#include "apdu_cache.hpp"
+#include "byte_io.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+size_t EncodedImage::fragment_count() const {
+    size_t n = 0;
+    for (const auto& block : blocks) n += block.size();
+    return n;
+}
+
+uint64_t fnv1a64(const void* data, size_t size, uint64_t hash) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// --- Serialization ---
+//
+// All integers little-endian:
+//   "EPDC" u16 version
+//   u32 packed size, packed bytes
+//   u16 block count; per block: u16 APDU count, APDUs (see byte_io.hpp)
+//   u64 FNV-1a of everything above
+
+static const char ENCODED_MAGIC[4] = {'E', 'P', 'D', 'C'};
+static const uint16_t ENCODED_VERSION = 1;
+
+std::vector<uint8_t> serialize_encoded_image(const EncodedImage& image) {
+    ByteWriter w;
+    w.bytes(reinterpret_cast<const uint8_t*>(ENCODED_MAGIC), 4);
+    w.u16(ENCODED_VERSION);
+    w.u32((uint32_t)image.packed.size());
+    w.bytes(image.packed.data(), image.packed.size());
+    w.u16((uint16_t)image.blocks.size());
+    for (const auto& block : image.blocks) write_apdu_block(w, block);
+    w.u64(fnv1a64(w.out.data(), w.out.size()));
+    return std::move(w.out);
+}
+
+EncodedImage deserialize_encoded_image(const uint8_t* data, size_t size) {
+    if (size < 8) throw std::runtime_error("Encoded image truncated");
+    ByteReader checksum(data + size - 8, 8);
+    if (checksum.u64() != fnv1a64(data, size - 8)) {
+        throw std::runtime_error("Encoded image checksum mismatch");
+    }
+
+    ByteReader r(data, size - 8);
+    const uint8_t* magic = r.bytes(4);
+    if (!std::equal(magic, magic + 4, ENCODED_MAGIC) || r.u16() != ENCODED_VERSION) {
+        throw std::runtime_error("Not an encoded image (or unsupported version)");
+    }
+
+    EncodedImage image;
+    uint32_t packed_size = r.u32();
+    const uint8_t* packed = r.bytes(packed_size);
+    image.packed.assign(packed, packed + packed_size);
+
+    image.blocks.resize(r.u16());
+    for (auto& block : image.blocks) block = read_apdu_block(r);
+    if (!r.at_end()) throw std::runtime_error("Trailing data after encoded image");
+    return image;
+}
+
+std::string default_cache_dir() {
+    if (const char* dir = std::getenv("SEND_EPAPER_CACHE_DIR"); dir && *dir) {
+        return dir;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::string(xdg) + "/send_epaper";
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return std::string(home) + "/.cache/send_epaper";
+    }
+    return "";
+}
+
+// --- ApduCache ---
+
+ApduCache::ApduCache(std::string dir, size_t memory_entries, uint64_t disk_bytes)
+    : dir_(disk_bytes ? std::move(dir) : std::string()), capacity_(std::max<size_t>(memory_entries, 1)),
+      disk_budget_(disk_bytes) {}
+
+std::string ApduCache::path_for(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.apdu", (unsigned long long)key);
+    return dir_ + "/" + name;
+}
+
+void ApduCache::remember(uint64_t key, std::shared_ptr<const EncodedImage> image) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        lru_.erase(it->second);
+    }
+    lru_.emplace_front(key, std::move(image));
+    index_[key] = lru_.begin();
+    if (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+std::shared_ptr<const EncodedImage> ApduCache::find(uint64_t key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            stats_.memory_hits++;
+            return it->second->second;
+        }
+    }
+
+    std::shared_ptr<const EncodedImage> image;
+    if (!dir_.empty()) {
+        std::string path = path_for(key);
+        std::vector<uint8_t> bytes;
+        if (read_file_bytes(path, bytes)) {
+            try {
+                image = std::make_shared<const EncodedImage>(
+                    deserialize_encoded_image(bytes.data(), bytes.size()));
+                // Eviction goes by mtime, so a hit makes the entry recent again
+                std::error_code ec;
+                fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+            } catch (const std::runtime_error&) {
+                // Corrupt or stale entry: drop it and re-encode
+                std::error_code ec;
+                fs::remove(path, ec);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (image) {
+        stats_.disk_hits++;
+        remember(key, image);
+    } else {
+        stats_.misses++;
+    }
+    return image;
+}
+
+void ApduCache::store(uint64_t key, std::shared_ptr<const EncodedImage> image) {
+    if (!dir_.empty()) {
+        auto bytes = serialize_encoded_image(*image);
+        if (write_file_atomic(path_for(key), bytes)) trim_disk(bytes.size());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.stores++;
+    remember(key, std::move(image));
+}
+
+void ApduCache::trim_disk(uint64_t added) {
+    std::lock_guard<std::mutex> disk_lock(disk_mutex_);
+    // Other processes share the directory, so the running total is only trusted
+    // while it stays under budget; going over triggers a fresh scan
+    if (disk_used_ >= 0) {
+        disk_used_ += (int64_t)added;
+        if ((uint64_t)disk_used_ <= disk_budget_) return;
+    }
+
+    struct Entry {
+        fs::file_time_type mtime;
+        uint64_t size;
+        fs::path path;
+    };
+    std::vector<Entry> entries;
+    uint64_t used = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".apdu") continue;
+        std::error_code entry_ec;
+        uint64_t size = it->file_size(entry_ec);
+        auto mtime = it->last_write_time(entry_ec);
+        if (entry_ec) continue;
+        entries.push_back({mtime, size, it->path()});
+        used += size;
+    }
+
+    int evicted = 0;
+    if (used > disk_budget_) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.mtime < b.mtime; });
+        for (const auto& entry : entries) {
+            if (used <= disk_budget_) break;
+            if (fs::remove(entry.path, ec)) {
+                used -= entry.size;
+                evicted++;
+            }
+        }
+    }
+    disk_used_ = (int64_t)used;
+
+    if (evicted) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.evictions += evicted;
+    }
+}
+
+ApduCacheStats ApduCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,291 @@
+#include "apdu_trace.hpp"
+#include "byte_io.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+// --- Serialization ---
+//
+// All integers little-endian:
+//   "EPTR" u16 version
+//   then events until the end of the file, each:
+//     u8 kind, u64 start_us, u32 duration_us
+//     Card:     u16 polls, u32 cycle_us, u32 activation_us, u16 max_unchained_apdu
+//     NoCard:   nothing
+//     Presence: u8 present
+//     Exchange: APDU (see byte_io.hpp); u16 status; u8 wtx; u16 response size, response bytes;
+//               u16 error size, error text
+//
+// A recording cut short mid-event loses only that event.
+
+static const char TRACE_MAGIC[4] = {'E', 'P', 'T', 'R'};
+static const uint16_t TRACE_VERSION = 1;
+
+static void write_event(ByteWriter& w, const TraceEvent& e) {
+    w.u8(e.kind);
+    w.u64(e.start_us);
+    w.u32(e.duration_us);
+    switch (e.kind) {
+    case TraceEvent::Card:
+        w.u16((uint16_t)std::min(e.detection.polls, 0xFFFF));
+        w.u32((uint32_t)(e.detection.cycle_ms * 1000.0));
+        w.u32((uint32_t)(e.detection.activation_ms * 1000.0));
+        w.u16((uint16_t)e.max_unchained_apdu);
+        break;
+    case TraceEvent::NoCard:
+        break;
+    case TraceEvent::Presence:
+        w.u8(e.present ? 1 : 0);
+        break;
+    case TraceEvent::Exchange:
+        write_apdu(w, e.apdu);
+        w.u16(e.status);
+        w.u8((uint8_t)std::min(e.wtx, 0xFF));
+        w.u16((uint16_t)e.response.size());
+        w.bytes(e.response.data(), e.response.size());
+        w.u16((uint16_t)e.error.size());
+        w.bytes(reinterpret_cast<const uint8_t*>(e.error.data()), e.error.size());
+        break;
+    }
+}
+
+static TraceEvent read_event(ByteReader& r) {
+    TraceEvent e;
+    uint8_t kind = r.u8();
+    if (kind < TraceEvent::Card || kind > TraceEvent::Exchange) {
+        throw std::runtime_error("Unknown trace event " + std::to_string(kind));
+    }
+    e.kind = (TraceEvent::Kind)kind;
+    e.start_us = r.u64();
+    e.duration_us = r.u32();
+    switch (e.kind) {
+    case TraceEvent::Card:
+        e.detection.polls = r.u16();
+        e.detection.cycle_ms = r.u32() / 1000.0;
+        e.detection.activation_ms = r.u32() / 1000.0;
+        e.max_unchained_apdu = r.u16();
+        break;
+    case TraceEvent::NoCard:
+        break;
+    case TraceEvent::Presence:
+        e.present = r.u8() != 0;
+        break;
+    case TraceEvent::Exchange: {
+        e.apdu = read_apdu(r);
+        e.status = r.u16();
+        e.wtx = r.u8();
+        size_t n = r.u16();
+        const uint8_t* data = r.bytes(n);
+        e.response.assign(data, data + n);
+        n = r.u16();
+        e.error.assign(reinterpret_cast<const char*>(r.bytes(n)), n);
+        break;
+    }
+    }
+    return e;
+}
+
+std::vector<TraceEvent> load_trace(const std::string& path) {
+    std::vector<uint8_t> bytes;
+    if (!read_file_bytes(path, bytes)) {
+        throw std::runtime_error("Cannot open trace: " + path);
+    }
+    ByteReader r(bytes.data(), bytes.size());
+    try {
+        const uint8_t* magic = r.bytes(4);
+        if (!std::equal(magic, magic + 4, TRACE_MAGIC) || r.u16() != TRACE_VERSION) {
+            throw std::runtime_error("bad header");
+        }
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error("Not an APDU trace: " + path);
+    }
+
+    std::vector<TraceEvent> events;
+    while (!r.at_end()) {
+        try {
+            events.push_back(read_event(r));
+        } catch (const std::runtime_error&) {
+            break;  // Truncated last event
+        }
+    }
+    return events;
+}
+
+static std::string hex(const Apdu& apdu) {
+    std::ostringstream out;
+    out << std::hex << std::uppercase << std::setfill('0');
+    for (uint8_t b : {apdu.cla, apdu.ins, apdu.p1, apdu.p2}) out << std::setw(2) << (int)b;
+    out << std::dec << " (" << apdu.data.size() << " data bytes)";
+    return out.str();
+}
+
+static bool same_command(const Apdu& a, const Apdu& b) {
+    return a.cla == b.cla && a.ins == b.ins && a.p1 == b.p1 && a.p2 == b.p2 &&
+           a.has_data == b.has_data && a.le == b.le && a.data == b.data;
+}
+
+// --- TraceRecorder ---
+
+TraceRecorder::TraceRecorder(std::unique_ptr<NfcTransport> inner, const std::string& path)
+    : inner_(std::move(inner)), file_(path, std::ios::binary | std::ios::trunc), path_(path),
+      start_(std::chrono::steady_clock::now()) {
+    if (!file_) {
+        throw std::runtime_error("Cannot write trace: " + path);
+    }
+    ByteWriter w;
+    w.bytes(reinterpret_cast<const uint8_t*>(TRACE_MAGIC), 4);
+    w.u16(TRACE_VERSION);
+    file_.write(reinterpret_cast<const char*>(w.out.data()), (std::streamsize)w.out.size());
+    file_.flush();
+}
+
+uint64_t TraceRecorder::since_start_us(std::chrono::steady_clock::time_point t) const {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(t - start_).count();
+}
+
+void TraceRecorder::write(TraceEvent& event, std::chrono::steady_clock::time_point start) {
+    auto now = std::chrono::steady_clock::now();
+    event.start_us = since_start_us(start);
+    event.duration_us = (uint32_t)std::min<uint64_t>(since_start_us(now) - event.start_us,
+                                                     UINT32_MAX);
+    ByteWriter w;
+    write_event(w, event);
+    file_.write(reinterpret_cast<const char*>(w.out.data()), (std::streamsize)w.out.size());
+    file_.flush();
+    events_++;
+}
+
+void TraceRecorder::card_event(bool found, std::chrono::steady_clock::time_point start) {
+    TraceEvent event;
+    event.kind = found ? TraceEvent::Card : TraceEvent::NoCard;
+    if (found) {
+        event.detection = inner_->last_detection();
+        event.max_unchained_apdu = inner_->max_unchained_apdu();
+    }
+    write(event, start);
+}
+
+void TraceRecorder::open() {
+    auto start = std::chrono::steady_clock::now();
+    inner_->open();
+    card_event(true, start);
+}
+
+bool TraceRecorder::wait_for_card(std::chrono::milliseconds timeout) {
+    auto start = std::chrono::steady_clock::now();
+    bool found = inner_->wait_for_card(timeout);
+    card_event(found, start);
+    return found;
+}
+
+bool TraceRecorder::card_present() {
+    auto start = std::chrono::steady_clock::now();
+    TraceEvent event;
+    event.kind = TraceEvent::Presence;
+    event.present = inner_->card_present();
+    write(event, start);
+    return event.present;
+}
+
+std::vector<uint8_t> TraceRecorder::send_apdu(const Apdu& apdu) {
+    auto start = std::chrono::steady_clock::now();
+    TraceEvent event;
+    event.kind = TraceEvent::Exchange;
+    event.apdu = apdu;
+    try {
+        event.response = inner_->send_apdu(apdu);
+        event.wtx = inner_->last_apdu_wtx();
+    } catch (const std::exception& e) {
+        event.error = e.what();
+        auto status = dynamic_cast<const ApduStatusError*>(&e);
+        event.status = status ? status->status() : 0;
+        event.wtx = inner_->last_apdu_wtx();
+        write(event, start);
+        throw;
+    }
+    write(event, start);
+    return event.response;
+}
+
+// --- TraceReplayTransport ---
+
+TraceReplayTransport::TraceReplayTransport(std::vector<TraceEvent> events, Timing timing)
+    : events_(std::move(events)), timing_(timing) {}
+
+int TraceReplayTransport::cards() const {
+    return (int)std::count_if(events_.begin(), events_.end(),
+                              [](const TraceEvent& e) { return e.kind == TraceEvent::Card; });
+}
+
+void TraceReplayTransport::take_time(const TraceEvent& event) const {
+    if (timing_ == Timing::Recorded && event.duration_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(event.duration_us));
+    }
+}
+
+void TraceReplayTransport::open() {
+    while (next_ < events_.size() && events_[next_].kind != TraceEvent::Card) next_++;
+    if (next_ == events_.size()) {
+        throw std::runtime_error("Trace replay: no card left in the trace");
+    }
+    wait_for_card(std::chrono::milliseconds(0));
+}
+
+bool TraceReplayTransport::wait_for_card(std::chrono::milliseconds timeout) {
+    // Presence checks the replaying run did not make are skipped
+    while (next_ < events_.size() && events_[next_].kind == TraceEvent::Presence) next_++;
+    if (next_ == events_.size()) {
+        if (timing_ == Timing::Recorded) std::this_thread::sleep_for(timeout);
+        return false;
+    }
+    const auto& event = events_[next_];
+    if (event.kind == TraceEvent::Exchange) {
+        throw std::runtime_error("Trace replay: looked for a card where the trace continues with APDU " +
+                                 hex(event.apdu));
+    }
+    next_++;
+    take_time(event);
+    if (event.kind == TraceEvent::NoCard) return false;
+    detection_ = event.detection;
+    max_unchained_ = event.max_unchained_apdu;
+    return true;
+}
+
+bool TraceReplayTransport::card_present() {
+    // Anything else next means the recorded card was gone by now
+    if (next_ == events_.size() || events_[next_].kind != TraceEvent::Presence) return false;
+    const auto& event = events_[next_++];
+    take_time(event);
+    return event.present;
+}
+
+std::vector<uint8_t> TraceReplayTransport::send_apdu(const Apdu& apdu) {
+    while (next_ < events_.size() && events_[next_].kind == TraceEvent::Presence) next_++;
+    exchanges_++;
+    if (next_ == events_.size() || events_[next_].kind != TraceEvent::Exchange) {
+        throw std::runtime_error("Trace replay: APDU " + std::to_string(exchanges_) + " " + hex(apdu) +
+                                 " has no recorded exchange");
+    }
+    const auto& event = events_[next_++];
+    if (!same_command(event.apdu, apdu)) {
+        std::string what = "Trace replay: APDU " + std::to_string(exchanges_) + " is " + hex(apdu);
+        if (hex(apdu) == hex(event.apdu)) {
+            auto diff = std::mismatch(apdu.data.begin(), apdu.data.end(), event.apdu.data.begin());
+            what += ", data differs from the trace at byte " +
+                    std::to_string(diff.first - apdu.data.begin());
+        } else {
+            what += ", the trace has " + hex(event.apdu);
+        }
+        throw std::runtime_error(what);
+    }
+    take_time(event);
+    wtx_ = event.wtx;
+    if (!event.error.empty()) {
+        if (event.status != 0) throw ApduStatusError(event.status);
+        throw std::runtime_error(event.error);
+    }
+    return event.response;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+// Little-endian byte serialization shared by the on-disk formats (internal header)
+
+#include "protocol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class ByteWriter {
+public:
+    void u8(uint8_t v) { out.push_back(v); }
+    void u16(uint16_t v) { put(v, 2); }
+    void u32(uint32_t v) { put(v, 4); }
+    void u64(uint64_t v) { put(v, 8); }
+    void bytes(const uint8_t* p, size_t n) { out.insert(out.end(), p, p + n); }
+
+    std::vector<uint8_t> out;
+
+private:
+    void put(uint64_t v, int n) {
+        for (int i = 0; i < n; i++) out.push_back((uint8_t)(v >> (8 * i)));
+    }
+};
+
+/// Reads from a bounded buffer; throws std::runtime_error when it runs out
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+    uint8_t u8() { return (uint8_t)get(1); }
+    uint16_t u16() { return (uint16_t)get(2); }
+    uint32_t u32() { return (uint32_t)get(4); }
+    uint64_t u64() { return get(8); }
+    const uint8_t* bytes(size_t n) {
+        need(n);
+        const uint8_t* p = p_;
+        p_ += n;
+        return p;
+    }
+    bool at_end() const { return p_ == end_; }
+    size_t remaining() const { return (size_t)(end_ - p_); }
+
+private:
+    void need(size_t n) const {
+        if ((size_t)(end_ - p_) < n) throw std::runtime_error("Unexpected end of data");
+    }
+    uint64_t get(int n) {
+        need(n);
+        uint64_t v = 0;
+        for (int i = 0; i < n; i++) v |= (uint64_t)p_[i] << (8 * i);
+        p_ += n;
+        return v;
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+// --- APDUs ---
+//
+// One APDU: u8 cla, ins, p1, p2, has_data; i32 le; u16 data size, data bytes
+// One block: u16 APDU count, then the APDUs
+
+inline void write_apdu(ByteWriter& w, const Apdu& apdu) {
+    w.u8(apdu.cla);
+    w.u8(apdu.ins);
+    w.u8(apdu.p1);
+    w.u8(apdu.p2);
+    w.u8(apdu.has_data ? 1 : 0);
+    w.u32((uint32_t)apdu.le);
+    w.u16((uint16_t)apdu.data.size());
+    w.bytes(apdu.data.data(), apdu.data.size());
+}
+
+inline Apdu read_apdu(ByteReader& r) {
+    Apdu apdu{};
+    apdu.cla = r.u8();
+    apdu.ins = r.u8();
+    apdu.p1 = r.u8();
+    apdu.p2 = r.u8();
+    apdu.has_data = r.u8() != 0;
+    apdu.le = (int32_t)r.u32();
+    size_t n = r.u16();
+    const uint8_t* data = r.bytes(n);
+    apdu.data.assign(data, data + n);
+    return apdu;
+}
+
+inline void write_apdu_block(ByteWriter& w, const std::vector<Apdu>& block) {
+    w.u16((uint16_t)block.size());
+    for (const auto& apdu : block) write_apdu(w, apdu);
+}
+
+inline std::vector<Apdu> read_apdu_block(ByteReader& r) {
+    std::vector<Apdu> block(r.u16());
+    for (auto& apdu : block) apdu = read_apdu(r);
+    return block;
+}
+
+/// Read a whole file; false if it cannot be opened
+inline bool read_file_bytes(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/// Write a file under a temporary name and rename it into place, so concurrent
+/// readers never see a partial file. Creates the parent directory. False on error.
+inline bool write_file_atomic(const std::string& path, const std::vector<uint8_t>& bytes) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    std::string tmp = path + ".tmp" + std::to_string(std::random_device()());
+    bool written;
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+        written = file.good();
+    }
+    if (written) fs::rename(tmp, path, ec);
+    if (!written || ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+#include "card_state.hpp"
+#include "apdu_cache.hpp"
+#include "byte_io.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+
+// Record layout (little-endian):
+//   "EPDS" u16 version; u16 width, height; u8 bits_per_pixel
+//   u32 packed size, packed bytes; u64 FNV-1a of everything above
+
+static const char STATE_MAGIC[4] = {'E', 'P', 'D', 'S'};
+static const uint16_t STATE_VERSION = 1;
+
+static std::vector<uint8_t> serialize_state(const DeviceInfo& info, const std::vector<uint8_t>& packed) {
+    ByteWriter w;
+    w.bytes(reinterpret_cast<const uint8_t*>(STATE_MAGIC), 4);
+    w.u16(STATE_VERSION);
+    w.u16((uint16_t)info.width);
+    w.u16((uint16_t)info.height);
+    w.u8((uint8_t)info.bits_per_pixel);
+    w.u32((uint32_t)packed.size());
+    w.bytes(packed.data(), packed.size());
+    w.u64(fnv1a64(w.out.data(), w.out.size()));
+    return std::move(w.out);
+}
+
+static bool parse_state(const std::vector<uint8_t>& bytes, const DeviceInfo& info,
+                        std::vector<uint8_t>& packed) {
+    if (bytes.size() < 8) return false;
+    try {
+        ByteReader checksum(bytes.data() + bytes.size() - 8, 8);
+        if (checksum.u64() != fnv1a64(bytes.data(), bytes.size() - 8)) return false;
+
+        ByteReader r(bytes.data(), bytes.size() - 8);
+        const uint8_t* magic = r.bytes(4);
+        if (!std::equal(magic, magic + 4, STATE_MAGIC) || r.u16() != STATE_VERSION) return false;
+        if (r.u16() != info.width || r.u16() != info.height || r.u8() != info.bits_per_pixel) {
+            return false;
+        }
+        uint32_t size = r.u32();
+        if ((int)size != info.fb_total_bytes()) return false;
+        const uint8_t* p = r.bytes(size);
+        packed.assign(p, p + size);
+        return r.at_end();
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+CardStateStore::CardStateStore(std::string dir) : dir_(std::move(dir)) {}
+
+std::string CardStateStore::path_for(const std::string& serial_number) const {
+    // Serials are card-supplied bytes: keep [A-Za-z0-9_-], hex-escape the rest
+    std::string name;
+    for (unsigned char c : serial_number) {
+        if (std::isalnum(c) || c == '-' || c == '_') {
+            name += (char)c;
+        } else {
+            char esc[4];
+            std::snprintf(esc, sizeof(esc), "%%%02X", c);
+            name += esc;
+        }
+    }
+    return dir_ + "/" + (name.empty() ? "%" : name) + ".fb";
+}
+
+bool CardStateStore::load(const DeviceInfo& device_info, std::vector<uint8_t>& packed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = memory_.find(device_info.serial_number);
+    if (it != memory_.end()) {
+        return parse_state(it->second, device_info, packed);
+    }
+    if (dir_.empty()) return false;
+
+    std::vector<uint8_t> bytes;
+    if (!read_file_bytes(path_for(device_info.serial_number), bytes)) return false;
+    if (!parse_state(bytes, device_info, packed)) return false;
+    memory_[device_info.serial_number] = std::move(bytes);
+    return true;
+}
+
+void CardStateStore::save(const DeviceInfo& device_info, const std::vector<uint8_t>& packed) {
+    auto bytes = serialize_state(device_info, packed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dir_.empty()) {
+        write_file_atomic(path_for(device_info.serial_number), bytes);
+    }
+    memory_[device_info.serial_number] = std::move(bytes);
+}
+
+void CardStateStore::forget(const std::string& serial_number) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_.erase(serial_number);
+    if (!dir_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(path_for(serial_number), ec);
+    }
+}
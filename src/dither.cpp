@@ -2,190 +2,423 @@
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "stb_image.h"
 #include "dither.hpp"
+#include "metrics.hpp"
 #include <cmath>
 #include <stdexcept>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <string>
 
 // --- Image loading and resizing ---
 
-std::vector<uint8_t> load_and_resize_image(const char* path,
-                                            int target_w, int target_h,
-                                            Color bg_color,
-                                            const std::string& resize_mode) {
-    int w, h, channels;
-    unsigned char* data = stbi_load(path, &w, &h, &channels, 4);  // Force RGBA
-    if (!data) {
+ImageRowSource::ImageRowSource(const char* path, int target_w, int target_h,
+                               Color bg_color, const std::string& resize_mode,
+                               ResampleFilter filter)
+    : target_w_(target_w), target_h_(target_h), bg_(bg_color), filter_(filter) {
+    static Histogram& decode_time = stage_histogram("decode");
+    int channels;
+    {
+        ScopedTimer timer(decode_time);
+        data_ = stbi_load(path, &src_w_, &src_h_, &channels, 4);  // Force RGBA
+    }
+    if (!data_) {
         throw std::runtime_error(std::string("Failed to load image: ") + path +
                                  " (" + stbi_failure_reason() + ")");
     }
+    init(resize_mode);
+}
 
-    // Composite alpha onto background color
-    std::vector<uint8_t> rgb(w * h * 3);
-    for (int i = 0; i < w * h; i++) {
-        float a = data[i * 4 + 3] / 255.0f;
-        rgb[i * 3 + 0] = static_cast<uint8_t>(data[i * 4 + 0] * a + bg_color.r * (1 - a));
-        rgb[i * 3 + 1] = static_cast<uint8_t>(data[i * 4 + 1] * a + bg_color.g * (1 - a));
-        rgb[i * 3 + 2] = static_cast<uint8_t>(data[i * 4 + 2] * a + bg_color.b * (1 - a));
+ImageRowSource::ImageRowSource(const uint8_t* encoded, size_t size, int target_w, int target_h,
+                               Color bg_color, const std::string& resize_mode,
+                               ResampleFilter filter)
+    : target_w_(target_w), target_h_(target_h), bg_(bg_color), filter_(filter) {
+    static Histogram& decode_time = stage_histogram("decode");
+    int channels;
+    {
+        ScopedTimer timer(decode_time);
+        data_ = stbi_load_from_memory(encoded, (int)size, &src_w_, &src_h_, &channels, 4);
+    }
+    if (!data_) {
+        throw std::runtime_error(std::string("Failed to decode image (") +
+                                 stbi_failure_reason() + ")");
     }
-    stbi_image_free(data);
+    init(resize_mode);
+}
+
+void ImageRowSource::init(const std::string& resize_mode) {
+    int w = src_w_, h = src_h_;
+    int target_w = target_w_, target_h = target_h_;
 
     // Calculate resize dimensions
-    int new_w, new_h;
-    if (resize_mode == "cover") {
-        float ratio = std::max((float)target_w / w, (float)target_h / h);
-        new_w = (int)(w * ratio);
-        new_h = (int)(h * ratio);
-    } else {  // fit
-        float ratio = std::min((float)target_w / w, (float)target_h / h);
-        new_w = (int)(w * ratio);
-        new_h = (int)(h * ratio);
-    }
-
-    // Simple bilinear resize
-    std::vector<uint8_t> resized(new_w * new_h * 3);
-    for (int y = 0; y < new_h; y++) {
-        for (int x = 0; x < new_w; x++) {
-            float src_x = (float)x * w / new_w;
-            float src_y = (float)y * h / new_h;
-            int sx = std::min((int)src_x, w - 1);
-            int sy = std::min((int)src_y, h - 1);
-            for (int c = 0; c < 3; c++) {
-                resized[(y * new_w + x) * 3 + c] = rgb[(sy * w + sx) * 3 + c];
-            }
+    bool cover = resize_mode == "cover";
+    float ratio = cover ? std::max((float)target_w / w, (float)target_h / h)
+                        : std::min((float)target_w / w, (float)target_h / h);
+    new_w_ = (int)(w * ratio);
+    new_h_ = (int)(h * ratio);
+
+    // Offset of the resized image on the canvas: center crop (cover) or center paste (fit)
+    off_x_ = cover ? -((new_w_ - target_w) / 2) : (target_w - new_w_) / 2;
+    off_y_ = cover ? -((new_h_ - target_h) / 2) : (target_h - new_h_) / 2;
+
+    if (filter_ == ResampleFilter::Nearest) {
+        // Nearest-neighbor source column for each canvas column (-1: background)
+        src_x_.assign(target_w, -1);
+        for (int x = 0; x < target_w; x++) {
+            int rx = x - off_x_;
+            if (rx < 0 || rx >= new_w_) continue;
+            float src_x = (float)rx * w / new_w_;
+            src_x_[x] = std::min((int)src_x, w - 1);
         }
+        return;
     }
 
-    // Create output canvas
-    std::vector<uint8_t> output(target_w * target_h * 3);
-    for (int i = 0; i < target_w * target_h; i++) {
-        output[i * 3 + 0] = bg_color.r;
-        output[i * 3 + 1] = bg_color.g;
-        output[i * 3 + 2] = bg_color.b;
-    }
-
-    if (resize_mode == "cover") {
-        // Center crop
-        int off_x = (new_w - target_w) / 2;
-        int off_y = (new_h - target_h) / 2;
-        for (int y = 0; y < target_h; y++) {
-            for (int x = 0; x < target_w; x++) {
-                int src_idx = ((y + off_y) * new_w + (x + off_x)) * 3;
-                int dst_idx = (y * target_w + x) * 3;
-                output[dst_idx + 0] = resized[src_idx + 0];
-                output[dst_idx + 1] = resized[src_idx + 1];
-                output[dst_idx + 2] = resized[src_idx + 2];
-            }
-        }
+    vis_x0_ = std::max(0, -off_x_);
+    vis_x1_ = std::min(new_w_, target_w - off_x_);
+    if (vis_x1_ <= vis_x0_ || new_h_ <= 0) {
+        vis_x0_ = vis_x1_ = 0;
+        return;
+    }
+    weights_x_ = compute_resample_weights(filter_, w, new_w_);
+    weights_y_ = compute_resample_weights(filter_, h, new_h_);
+
+    int visible = vis_x1_ - vis_x0_;
+    premul_.resize((size_t)w * 4);
+    ring_.resize((size_t)weights_y_.max_taps * visible * 4);
+    ring_row_.assign(weights_y_.max_taps, -1);
+    window_.resize(weights_y_.max_taps);
+    column_.resize((size_t)visible * 4);
+}
+
+ImageRowSource::~ImageRowSource() {
+    stbi_image_free(data_);
+}
+
+void ImageRowSource::fill_background(uint8_t* rgb, int x0, int x1) const {
+    for (int x = x0; x < x1; x++) {
+        rgb[x * 3 + 0] = (uint8_t)bg_.r;
+        rgb[x * 3 + 1] = (uint8_t)bg_.g;
+        rgb[x * 3 + 2] = (uint8_t)bg_.b;
+    }
+}
+
+void ImageRowSource::next_row(uint8_t* rgb) {
+    int y = y_++;
+    int ry = y - off_y_;
+
+    if (ry < 0 || ry >= new_h_) {
+        fill_background(rgb, 0, target_w_);
+        return;
+    }
+    if (filter_ == ResampleFilter::Nearest) {
+        nearest_row(ry, rgb);
     } else {
-        // Center paste (fit)
-        int off_x = (target_w - new_w) / 2;
-        int off_y = (target_h - new_h) / 2;
-        for (int y = 0; y < new_h; y++) {
-            for (int x = 0; x < new_w; x++) {
-                int dst_idx = ((y + off_y) * target_w + (x + off_x)) * 3;
-                int src_idx = (y * new_w + x) * 3;
-                output[dst_idx + 0] = resized[src_idx + 0];
-                output[dst_idx + 1] = resized[src_idx + 1];
-                output[dst_idx + 2] = resized[src_idx + 2];
-            }
+        filtered_row(ry, rgb);
+    }
+}
+
+void ImageRowSource::nearest_row(int ry, uint8_t* rgb) {
+    float src_y = (float)ry * src_h_ / new_h_;
+    int sy = std::min((int)src_y, src_h_ - 1);
+    const uint8_t* src_row = data_ + (size_t)sy * src_w_ * 4;
+
+    for (int x = 0; x < target_w_; x++) {
+        if (src_x_[x] < 0) {
+            fill_background(rgb, x, x + 1);
+            continue;
         }
+        // Composite alpha onto background color
+        const uint8_t* px = src_row + src_x_[x] * 4;
+        float a = px[3] / 255.0f;
+        rgb[x * 3 + 0] = static_cast<uint8_t>(px[0] * a + bg_.r * (1 - a));
+        rgb[x * 3 + 1] = static_cast<uint8_t>(px[1] * a + bg_.g * (1 - a));
+        rgb[x * 3 + 2] = static_cast<uint8_t>(px[2] * a + bg_.b * (1 - a));
     }
+}
 
-    return output;
+const float* ImageRowSource::filtered_source_row(int sy) {
+    // Vertical windows only move down, so a ring of max_taps slots keyed by
+    // source row keeps every row that the current window still needs
+    int slot = sy % weights_y_.max_taps;
+    float* row = &ring_[(size_t)slot * (vis_x1_ - vis_x0_) * 4];
+    if (ring_row_[slot] != sy) {
+        // Premultiply only the source columns the visible outputs read
+        int first = weights_x_.start[vis_x0_];
+        int last = weights_x_.start[vis_x1_ - 1] + weights_x_.count[vis_x1_ - 1];
+        premultiply_row(data_ + ((size_t)sy * src_w_ + first) * 4, last - first,
+                        premul_.data() + (size_t)first * 4);
+        resample_row(premul_.data(), weights_x_, vis_x0_, vis_x1_, row);
+        ring_row_[slot] = sy;
+    }
+    return row;
 }
 
-// --- Nearest color ---
+void ImageRowSource::filtered_row(int ry, uint8_t* rgb) {
+    int canvas_x0 = vis_x0_ + off_x_;
+    int canvas_x1 = vis_x1_ + off_x_;
+    fill_background(rgb, 0, canvas_x0);
+    fill_background(rgb, canvas_x1, target_w_);
+    if (canvas_x1 <= canvas_x0) return;
 
-static int nearest_color(int r, int g, int b, const std::array<Color, 4>& palette) {
-    int best_idx = 0;
-    int best_dist = INT32_MAX;
-    for (int i = 0; i < (int)palette.size(); i++) {
-        int dr = r - palette[i].r;
-        int dg = g - palette[i].g;
-        int db = b - palette[i].b;
-        int dist = dr * dr + dg * dg + db * db;
-        if (dist < best_dist) {
-            best_dist = dist;
-            best_idx = i;
-        }
+    int taps = weights_y_.count[ry];
+    for (int k = 0; k < taps; k++) {
+        window_[k] = filtered_source_row(weights_y_.start[ry] + k);
     }
-    return best_idx;
+    int n = (vis_x1_ - vis_x0_) * 4;
+    resample_column(window_.data(), &weights_y_.weights[(size_t)ry * weights_y_.max_taps], taps, n,
+                    column_.data());
+
+    const float bg[3] = {(float)bg_.r, (float)bg_.g, (float)bg_.b};
+    composite_row(column_.data(), vis_x1_ - vis_x0_, bg, rgb + (size_t)canvas_x0 * 3);
+}
+
+std::vector<uint8_t> load_and_resize_image(const char* path,
+                                            int target_w, int target_h,
+                                            Color bg_color,
+                                            const std::string& resize_mode,
+                                            ResampleFilter filter) {
+    ImageRowSource source(path, target_w, target_h, bg_color, resize_mode, filter);
+    std::vector<uint8_t> output((size_t)target_w * target_h * 3);
+    static Histogram& resize_time = stage_histogram("resize");
+    ScopedTimer timer(resize_time);
+    for (int y = 0; y < target_h; y++) {
+        source.next_row(output.data() + (size_t)y * target_w * 3);
+    }
+    return output;
 }
 
 // --- Atkinson dithering ---
 
-std::vector<std::vector<int>> dither_atkinson(const std::vector<uint8_t>& rgb,
-                                               int width, int height,
-                                               const std::array<Color, 4>& palette) {
-    // Working copy as float for error diffusion
-    std::vector<std::vector<float>> err_r(height, std::vector<float>(width, 0));
-    std::vector<std::vector<float>> err_g(height, std::vector<float>(width, 0));
-    std::vector<std::vector<float>> err_b(height, std::vector<float>(width, 0));
-
-    // Initialize with source pixel values
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int idx = (y * width + x) * 3;
-            err_r[y][x] = rgb[idx + 0];
-            err_g[y][x] = rgb[idx + 1];
-            err_b[y][x] = rgb[idx + 2];
-        }
+namespace {
+
+/// One error-diffusion tap: `weight` / 2^SHIFT of the error goes to (x+dx, y+dy)
+struct DiffusionTap {
+    int dx, dy, weight;
+};
+
+/// Atkinson distributes 6/8 of the error (1/8 each to 6 neighbors):
+/// (x+1,y), (x+2,y), (x-1,y+1), (x,y+1), (x+1,y+1), (x,y+2)
+struct AtkinsonKernel {
+    static constexpr int SHIFT = 3;
+    static constexpr int ROWS_BELOW = 2;
+    static constexpr DiffusionTap TAPS[] = {
+        {1, 0, 1}, {2, 0, 1},
+        {-1, 1, 1}, {0, 1, 1}, {1, 1, 1},
+        {0, 2, 1},
+    };
+};
+
+/// Floyd–Steinberg: 7/16 right, 3/16 below-left, 5/16 below, 1/16 below-right
+struct FloydSteinbergKernel {
+    static constexpr int SHIFT = 4;
+    static constexpr int ROWS_BELOW = 1;
+    static constexpr DiffusionTap TAPS[] = {
+        {1, 0, 7},
+        {-1, 1, 3}, {0, 1, 5}, {1, 1, 1},
+    };
+};
+
+/// Columns row y-1 must have finished before pixel x of row y may run: x + lag.
+/// Covers reads of (x, y) and writes to row y racing with row y-1's writes.
+template <class Kernel>
+constexpr int wavefront_lag() {
+    int max_right = 0, min_below = 0;
+    for (const auto& t : Kernel::TAPS) {
+        if (t.dy == 0) max_right = std::max(max_right, t.dx);
+        else min_below = std::min(min_below, t.dx);
     }
+    return max_right - min_below + 1;
+}
+
+/// Error-diffusion ditherer in fixed point.
+///
+/// Errors are kept as int16 in 1/2^SHIFT units. The quantization error of a
+/// clamped integer pixel is an integer, so every tap share is an exact integer and
+/// the result is bit-identical to the float formulation. Error rows live in a ring
+/// sized for the current band plus the rows below it; rows are padded by one pixel
+/// on the left and two on the right so taps are written without bounds checks.
+///
+/// With a thread pool, the rows of a band run as a wavefront: row y proceeds while
+/// row y-1 stays wavefront_lag() columns ahead. Integer accumulation makes the
+/// result independent of scheduling, so it matches the serial output exactly.
+template <class Kernel>
+class DiffusionRowDitherer : public RowDitherer {
+public:
+    DiffusionRowDitherer(int width, const PaletteQuantizer& quantizer, ThreadPool* pool)
+        : RowDitherer(width), row_len_((size_t)(width + PAD_LEFT + PAD_RIGHT) * 3),
+          quantizer_(quantizer), pool_(pool) {
+        reserve(1);
+    }
+
+    void dither_row(const uint8_t* rgb, uint8_t* out) override {
+        dither_rows(rgb, 1, out, 0);
+    }
+
+    void dither_rows(const uint8_t* rgb, int rows, uint8_t* out, int out_stride) override {
+        reserve(rows);
 
-    std::vector<std::vector<int>> result(height, std::vector<int>(width, 0));
-
-    // Atkinson distributes 6/8 of the error (1/8 each to 6 neighbors)
-    // Neighbors: (x+1,y), (x+2,y), (x-1,y+1), (x,y+1), (x+1,y+1), (x,y+2)
-    auto distribute = [&](int x, int y, float er, float eg, float eb) {
-        const float coeff = 1.0f / 8.0f;
-        const int offsets[][2] = {
-            {1, 0}, {2, 0},
-            {-1, 1}, {0, 1}, {1, 1},
-            {0, 2}
-        };
-        for (auto& off : offsets) {
-            int nx = x + off[0];
-            int ny = y + off[1];
-            if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-                err_r[ny][nx] += er * coeff;
-                err_g[ny][nx] += eg * coeff;
-                err_b[ny][nx] += eb * coeff;
+        if (!pool_ || pool_->workers() == 0 || rows < 2) {
+            for (int i = 0; i < rows; i++) {
+                process(i, 0, width_, rgb + (size_t)i * width_ * 3, out + (size_t)i * out_stride);
             }
+        } else {
+            const int lag = wavefront_lag<Kernel>();
+            std::vector<std::atomic<int>> done(rows);  // Columns finished per row
+            for (auto& d : done) d.store(0, std::memory_order_relaxed);
+
+            pool_->parallel_for(rows, [&](int i) {
+                const uint8_t* src = rgb + (size_t)i * width_ * 3;
+                uint8_t* dst = out + (size_t)i * out_stride;
+                for (int x0 = 0; x0 < width_; x0 += CHUNK) {
+                    int x1 = std::min(width_, x0 + CHUNK);
+                    if (i > 0) {
+                        int need = std::min(width_, x1 - 1 + lag);
+                        while (done[i - 1].load(std::memory_order_acquire) < need) {
+                            std::this_thread::yield();
+                        }
+                    }
+                    process(i, x0, x1, src, dst);
+                    done[i].store(x1, std::memory_order_release);
+                }
+            });
         }
-    };
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int r = std::clamp((int)std::round(err_r[y][x]), 0, 255);
-            int g = std::clamp((int)std::round(err_g[y][x]), 0, 255);
-            int b = std::clamp((int)std::round(err_b[y][x]), 0, 255);
+        // Finished rows are recycled; the next band starts at the carried rows
+        for (int i = 0; i < rows; i++) {
+            std::fill(ring_row(i), ring_row(i) + row_len_, 0);
+        }
+        base_ = (base_ + rows) % ring_rows_;
+    }
 
-            int idx = nearest_color(r, g, b, palette);
-            result[y][x] = idx;
+private:
+    static const int PAD_LEFT = 1;
+    static const int PAD_RIGHT = 2;
+    static const int CHUNK = 16;  // Columns published at once in wavefront mode
+    static const int ONE = 1 << Kernel::SHIFT;
+    static const int MAX_VALUE = 255 * ONE + ONE / 2 - 1;  // Largest value that rounds to 255
 
-            float er = (float)r - palette[idx].r;
-            float eg = (float)g - palette[idx].g;
-            float eb = (float)b - palette[idx].b;
+    int16_t* ring_row(int i) { return err_.data() + (size_t)((base_ + i) % ring_rows_) * row_len_; }
 
-            distribute(x, y, er, eg, eb);
+    /// Make room for `rows` band rows plus the rows below, keeping carried error
+    void reserve(int rows) {
+        int needed = rows + Kernel::ROWS_BELOW;
+        if (needed <= ring_rows_) return;
+        std::vector<int16_t> grown((size_t)needed * row_len_, 0);
+        for (int k = 0; k < Kernel::ROWS_BELOW && ring_rows_ > 0; k++) {
+            std::copy(ring_row(k), ring_row(k) + row_len_, grown.begin() + (size_t)k * row_len_);
         }
+        err_ = std::move(grown);
+        ring_rows_ = needed;
+        base_ = 0;
     }
 
-    return result;
-}
+    /// Dither columns [x0, x1) of band row i
+    void process(int i, int x0, int x1, const uint8_t* rgb, uint8_t* out) {
+        int16_t* rows[Kernel::ROWS_BELOW + 1];
+        for (int k = 0; k <= Kernel::ROWS_BELOW; k++) {
+            rows[k] = ring_row(i + k) + PAD_LEFT * 3;
+        }
+        const int16_t* cur = rows[0];
+        const auto& palette = quantizer_.palette();
+
+        for (int x = x0; x < x1; x++) {
+            const int p = x * 3;
+            // Round half up after clamping == clamp after rounding for these values
+            int r = (std::clamp(rgb[p + 0] * ONE + cur[p + 0], 0, MAX_VALUE) + ONE / 2) >> Kernel::SHIFT;
+            int g = (std::clamp(rgb[p + 1] * ONE + cur[p + 1], 0, MAX_VALUE) + ONE / 2) >> Kernel::SHIFT;
+            int b = (std::clamp(rgb[p + 2] * ONE + cur[p + 2], 0, MAX_VALUE) + ONE / 2) >> Kernel::SHIFT;
+
+            int idx = quantizer_.nearest(r, g, b);
+            out[x] = (uint8_t)idx;
+
+            const int e[3] = {r - palette[idx].r, g - palette[idx].g, b - palette[idx].b};
+            for (const auto& t : Kernel::TAPS) {
+                int16_t* dst = rows[t.dy] + p + t.dx * 3;
+                dst[0] = (int16_t)(dst[0] + e[0] * t.weight);
+                dst[1] = (int16_t)(dst[1] + e[1] * t.weight);
+                dst[2] = (int16_t)(dst[2] + e[2] * t.weight);
+            }
+        }
+    }
 
-std::vector<std::vector<int>> dither_none(const std::vector<uint8_t>& rgb,
-                                           int width, int height,
-                                           const std::array<Color, 4>& palette) {
-    std::vector<std::vector<int>> result(height, std::vector<int>(width, 0));
+    size_t row_len_;
+    const PaletteQuantizer& quantizer_;
+    ThreadPool* pool_;
+    std::vector<int16_t> err_;  // Ring of padded rows of interleaved RGB error
+    int ring_rows_ = 0;
+    int base_ = 0;              // Ring index of the current band's first row
+};
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int idx = (y * width + x) * 3;
-            result[y][x] = nearest_color(rgb[idx], rgb[idx + 1], rgb[idx + 2], palette);
+class NearestRowDitherer : public RowDitherer {
+public:
+    NearestRowDitherer(int width, const PaletteQuantizer& quantizer)
+        : RowDitherer(width), quantizer_(quantizer) {}
+
+    void dither_row(const uint8_t* rgb, uint8_t* out) override {
+        for (int x = 0; x < width_; x++) {
+            out[x] = (uint8_t)quantizer_.nearest(rgb[x * 3], rgb[x * 3 + 1], rgb[x * 3 + 2]);
         }
     }
 
+private:
+    const PaletteQuantizer& quantizer_;
+};
+
+Framebuffer dither_rows(RowDitherer& ditherer, const std::vector<uint8_t>& rgb, int width, int height) {
+    static Histogram& dither_time = stage_histogram("dither");
+    ScopedTimer timer(dither_time);
+    const int band = 64;
+    Framebuffer result(width, height);
+    for (int y = 0; y < height; y += band) {
+        ditherer.dither_rows(rgb.data() + (size_t)y * width * 3, std::min(band, height - y),
+                             result.row(y), result.stride());
+    }
     return result;
 }
+
+}  // namespace
+
+void RowDitherer::dither_rows(const uint8_t* rgb, int rows, uint8_t* out, int out_stride) {
+    for (int r = 0; r < rows; r++) {
+        dither_row(rgb + (size_t)r * width_ * 3, out + (size_t)r * out_stride);
+    }
+}
+
+std::unique_ptr<RowDitherer> make_row_ditherer(const std::string& method, int width,
+                                               const PaletteQuantizer& quantizer,
+                                               ThreadPool* pool) {
+    if (method == "atkinson") {
+        return std::make_unique<DiffusionRowDitherer<AtkinsonKernel>>(width, quantizer, pool);
+    }
+    if (method == "floyd-steinberg") {
+        return std::make_unique<DiffusionRowDitherer<FloydSteinbergKernel>>(width, quantizer, pool);
+    }
+    if (method == "none") return std::make_unique<NearestRowDitherer>(width, quantizer);
+    if (method == "bayer" || method == "bluenoise") {
+        return make_ordered_ditherer(method, width, quantizer, pool);
+    }
+    throw std::runtime_error("Unknown dither method: " + method);
+}
+
+Framebuffer dither_atkinson(const std::vector<uint8_t>& rgb,
+                            int width, int height,
+                            const PaletteQuantizer& quantizer,
+                            ThreadPool* pool) {
+    DiffusionRowDitherer<AtkinsonKernel> ditherer(width, quantizer, pool);
+    return dither_rows(ditherer, rgb, width, height);
+}
+
+Framebuffer dither_floyd_steinberg(const std::vector<uint8_t>& rgb,
+                                   int width, int height,
+                                   const PaletteQuantizer& quantizer,
+                                   ThreadPool* pool) {
+    DiffusionRowDitherer<FloydSteinbergKernel> ditherer(width, quantizer, pool);
+    return dither_rows(ditherer, rgb, width, height);
+}
+
+Framebuffer dither_none(const std::vector<uint8_t>& rgb,
+                        int width, int height,
+                        const PaletteQuantizer& quantizer) {
+    NearestRowDitherer ditherer(width, quantizer);
+    return dither_rows(ditherer, rgb, width, height);
+}
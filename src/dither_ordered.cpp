@@ -0,0 +1,171 @@
+#include "dither.hpp"
+#include "bluenoise_mask.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+// --- Threshold maps ---
+
+/// Square threshold map tiled over the image; holds per-cell offsets already
+/// scaled to the channel range
+struct ThresholdMap {
+    int size;                     // power of two
+    std::vector<int16_t> offset;  // size * size
+};
+
+/// Spread of the threshold offsets. One full palette step (0 -> 255), so a
+/// mid-level channel alternates between both neighbors half of the time.
+static const float ORDERED_SPREAD = 255.0f;
+
+static ThresholdMap make_threshold_map(const std::vector<int>& ranks, int size) {
+    ThresholdMap map{size, std::vector<int16_t>(ranks.size())};
+    const float levels = (float)ranks.size();
+    for (size_t i = 0; i < ranks.size(); i++) {
+        float t = (ranks[i] + 0.5f) / levels - 0.5f;  // (-0.5, 0.5)
+        map.offset[i] = (int16_t)std::lround(t * ORDERED_SPREAD);
+    }
+    return map;
+}
+
+/// 8x8 Bayer matrix, built recursively from the 2x2 index matrix
+static const ThresholdMap& bayer_map() {
+    static const ThresholdMap map = [] {
+        std::vector<int> m = {0};
+        int n = 1;
+        while (n < 8) {
+            std::vector<int> next((size_t)4 * n * n);
+            for (int y = 0; y < n; y++) {
+                for (int x = 0; x < n; x++) {
+                    int v = 4 * m[y * n + x];
+                    next[y * 2 * n + x] = v;
+                    next[y * 2 * n + x + n] = v + 2;
+                    next[(y + n) * 2 * n + x] = v + 3;
+                    next[(y + n) * 2 * n + x + n] = v + 1;
+                }
+            }
+            m = std::move(next);
+            n *= 2;
+        }
+        return make_threshold_map(m, n);
+    }();
+    return map;
+}
+
+/// 64x64 blue-noise mask (void-and-cluster; precomputed by tools/gen_bluenoise.cpp)
+static const ThresholdMap& bluenoise_map() {
+    static const ThresholdMap map = make_threshold_map(
+        std::vector<int>(std::begin(BLUENOISE_RANKS), std::end(BLUENOISE_RANKS)), BLUENOISE_SIZE);
+    return map;
+}
+
+// --- Ordered dithering ---
+
+namespace {
+
+/// Adds the tiled threshold offset to every channel and quantizes through the
+/// palette LUT. Pixels are independent, so bands of rows are dithered in
+/// parallel on a thread pool.
+class OrderedRowDitherer : public RowDitherer {
+public:
+    OrderedRowDitherer(const ThresholdMap& map, int width, const PaletteQuantizer& quantizer,
+                       ThreadPool* pool)
+        : RowDitherer(width), map_(map), quantizer_(quantizer), pool_(pool) {}
+
+    void dither_row(const uint8_t* rgb, uint8_t* out) override {
+        dither_one(row_++, rgb, out);
+    }
+
+    void dither_rows(const uint8_t* rgb, int rows, uint8_t* out, int out_stride) override {
+        int first = row_;
+        row_ += rows;
+        if (!pool_ || pool_->workers() == 0 || rows == 1) {
+            for (int r = 0; r < rows; r++) {
+                dither_one(first + r, rgb + (size_t)r * width_ * 3, out + (size_t)r * out_stride);
+            }
+            return;
+        }
+
+        // One tile per group of rows
+        const int tile_rows = std::max(1, TILE_PIXELS / std::max(1, width_));
+        const int tiles = (rows + tile_rows - 1) / tile_rows;
+        pool_->parallel_for(tiles, [&](int t) {
+            int end = std::min(rows, (t + 1) * tile_rows);
+            for (int r = t * tile_rows; r < end; r++) {
+                dither_one(first + r, rgb + (size_t)r * width_ * 3, out + (size_t)r * out_stride);
+            }
+        });
+    }
+
+private:
+    static const int TILE_PIXELS = 4096;  // Target pixels per parallel tile
+
+    void dither_one(int y, const uint8_t* rgb, uint8_t* out) const {
+        const int mask = map_.size - 1;
+        const int16_t* offsets = &map_.offset[(size_t)(y & mask) * map_.size];
+
+        // CHUNK is a multiple of the map size, so every chunk starts at mask column 0
+        // and shares one per-channel offset row
+        int16_t expanded[3 * CHUNK];
+        for (int i = 0; i < 3 * CHUNK; i++) {
+            expanded[i] = offsets[(i / 3) & mask];
+        }
+
+        // Offset and clamp in one pass (vectorizable), then look up in the LUT
+        uint8_t biased[3 * CHUNK];
+        for (int x0 = 0; x0 < width_; x0 += CHUNK) {
+            int n = std::min(CHUNK, width_ - x0);
+            const uint8_t* src = rgb + (size_t)x0 * 3;
+            for (int i = 0; i < n * 3; i++) {
+                biased[i] = (uint8_t)std::clamp(src[i] + expanded[i], 0, 255);
+            }
+            for (int i = 0; i < n; i++) {
+                out[x0 + i] = (uint8_t)quantizer_.nearest(biased[i * 3], biased[i * 3 + 1], biased[i * 3 + 2]);
+            }
+        }
+    }
+
+    static const int CHUNK = 64;  // pixels; multiple of every map size
+
+    const ThresholdMap& map_;
+    const PaletteQuantizer& quantizer_;
+    ThreadPool* pool_;
+    int row_ = 0;
+};
+
+Framebuffer dither_ordered(const ThresholdMap& map, const std::vector<uint8_t>& rgb,
+                           int width, int height, const PaletteQuantizer& quantizer,
+                           ThreadPool* pool) {
+    static Histogram& dither_time = stage_histogram("dither");
+    ScopedTimer timer(dither_time);
+    Framebuffer result(width, height);
+    OrderedRowDitherer ditherer(map, width, quantizer, pool);
+    ditherer.dither_rows(rgb.data(), height, result.data(), result.stride());
+    return result;
+}
+
+}  // namespace
+
+std::unique_ptr<RowDitherer> make_ordered_ditherer(const std::string& method, int width,
+                                                   const PaletteQuantizer& quantizer,
+                                                   ThreadPool* pool) {
+    if (method == "bayer") {
+        return std::make_unique<OrderedRowDitherer>(bayer_map(), width, quantizer, pool);
+    }
+    if (method == "bluenoise") {
+        return std::make_unique<OrderedRowDitherer>(bluenoise_map(), width, quantizer, pool);
+    }
+    throw std::runtime_error("Unknown ordered dither method: " + method);
+}
+
+Framebuffer dither_bayer(const std::vector<uint8_t>& rgb, int width, int height,
+                         const PaletteQuantizer& quantizer, ThreadPool* pool) {
+    return dither_ordered(bayer_map(), rgb, width, height, quantizer, pool);
+}
+
+Framebuffer dither_bluenoise(const std::vector<uint8_t>& rgb, int width, int height,
+                             const PaletteQuantizer& quantizer, ThreadPool* pool) {
+    return dither_ordered(bluenoise_map(), rgb, width, height, quantizer, pool);
+}
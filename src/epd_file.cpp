@@ -0,0 +1,220 @@
+#include "epd_file.hpp"
+#include "byte_io.hpp"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- Layout ---
+//
+// All integers little-endian:
+//   "EPDF" u16 version
+//   u16 width, u16 height, u8 bits_per_pixel, u8 rows_per_block, u16 max_fragment_data
+//   u64 content hash
+//   u16 block count, u32 fragment count
+//   extents, packed framebuffer first, then one per block:
+//     u32 offset, u32 size, u64 FNV-1a of those bytes
+//   u64 FNV-1a of everything above
+// Then the data the extents point at:
+//   packed bytes
+//   per block: u16 APDU count, APDUs (see byte_io.hpp)
+
+static const char EPD_MAGIC[4] = {'E', 'P', 'D', 'F'};
+static const uint16_t EPD_VERSION = 1;
+static const size_t EPD_FIXED_SIZE = 4 + 2 + 8 + 8 + 6;
+static const size_t EPD_EXTENT_SIZE = 4 + 4 + 8;
+
+EpdHeader compile_epd(const char* image_path, const std::string& epd_path,
+                      const DeviceInfo& device_info, const RenderOptions& options) {
+    // Hash and render the same bytes, so the hash always matches the content
+    std::vector<uint8_t> source;
+    if (!read_file_bytes(image_path, source)) {
+        throw std::runtime_error(std::string("Failed to load image: ") + image_path);
+    }
+    auto image = render_encoded(source.data(), source.size(), device_info, options);
+
+    EpdHeader header;
+    header.width = device_info.width;
+    header.height = device_info.height;
+    header.bits_per_pixel = device_info.bits_per_pixel;
+    header.rows_per_block = device_info.rows_per_block;
+    header.max_fragment_data = device_info.max_fragment_data;
+    header.content_hash = render_cache_key(source.data(), source.size(), options, device_info);
+    header.packed_size = image->packed.size();
+    header.blocks = (int)image->blocks.size();
+    header.fragments = image->fragment_count();
+
+    ByteWriter data;
+    data.bytes(image->packed.data(), image->packed.size());
+    std::vector<size_t> ends = {data.out.size()};
+    for (const auto& block : image->blocks) {
+        write_apdu_block(data, block);
+        ends.push_back(data.out.size());
+    }
+
+    ByteWriter w;
+    w.bytes(reinterpret_cast<const uint8_t*>(EPD_MAGIC), 4);
+    w.u16(EPD_VERSION);
+    w.u16((uint16_t)header.width);
+    w.u16((uint16_t)header.height);
+    w.u8((uint8_t)header.bits_per_pixel);
+    w.u8((uint8_t)header.rows_per_block);
+    w.u16((uint16_t)header.max_fragment_data);
+    w.u64(header.content_hash);
+    w.u16((uint16_t)header.blocks);
+    w.u32((uint32_t)header.fragments);
+    const size_t data_start = EPD_FIXED_SIZE + ends.size() * EPD_EXTENT_SIZE + 8;
+    size_t begin = 0;
+    for (size_t end : ends) {
+        w.u32((uint32_t)(data_start + begin));
+        w.u32((uint32_t)(end - begin));
+        w.u64(fnv1a64(data.out.data() + begin, end - begin));
+        begin = end;
+    }
+    w.u64(fnv1a64(w.out.data(), w.out.size()));
+    w.bytes(data.out.data(), data.out.size());
+
+    if (!write_file_atomic(epd_path, w.out)) {
+        throw std::runtime_error("Cannot write " + epd_path);
+    }
+    return header;
+}
+
+std::shared_ptr<const EncodedImage> load_epd(const char* path, const DeviceInfo& device_info) {
+    EpdFile epd(path);
+    epd.check(device_info);
+    auto image = std::make_shared<EncodedImage>();
+    image->packed = epd.packed();
+    for (int b = 0; b < epd.header().blocks; b++) image->blocks.push_back(epd.block(b));
+    return image;
+}
+
+bool is_epd_file(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[4] = {};
+    return file.read(magic, 4) && std::equal(magic, magic + 4, EPD_MAGIC);
+}
+
+// --- EpdFile ---
+
+EpdFile::EpdFile(const std::string& path) : path_(path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < EPD_FIXED_SIZE) {
+        ::close(fd);
+        throw std::runtime_error("Not a precompiled image: " + path);
+    }
+    size_ = (size_t)st.st_size;
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file
+    if (map == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + path);
+    }
+    data_ = static_cast<const uint8_t*>(map);
+
+    try {
+        ByteReader r(data_, size_);
+        const uint8_t* magic = r.bytes(4);
+        if (!std::equal(magic, magic + 4, EPD_MAGIC) || r.u16() != EPD_VERSION) {
+            throw std::runtime_error("Not a precompiled image (or unsupported version): " + path);
+        }
+        header_.width = r.u16();
+        header_.height = r.u16();
+        header_.bits_per_pixel = r.u8();
+        header_.rows_per_block = r.u8();
+        header_.max_fragment_data = r.u16();
+        header_.content_hash = r.u64();
+        header_.blocks = r.u16();
+        header_.fragments = r.u32();
+
+        auto read_extent = [&] {
+            Extent extent;
+            extent.offset = r.u32();
+            extent.size = r.u32();
+            extent.checksum = r.u64();
+            if (extent.offset > size_ || extent.size > size_ - extent.offset) {
+                throw std::runtime_error("Precompiled image is truncated: " + path);
+            }
+            return extent;
+        };
+        packed_ = read_extent();
+        header_.packed_size = packed_.size;
+        for (int b = 0; b < header_.blocks; b++) blocks_.push_back(read_extent());
+
+        size_t header_size = size_ - r.remaining();
+        if (r.u64() != fnv1a64(data_, header_size)) {
+            throw std::runtime_error("Precompiled image header checksum mismatch: " + path);
+        }
+    } catch (...) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        throw;
+    }
+}
+
+EpdFile::~EpdFile() {
+    munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+std::string EpdFile::mismatch(const DeviceInfo& device_info) const {
+    auto panel = [](int w, int h, int bpp, int rows) {
+        return std::to_string(w) + "x" + std::to_string(h) + ", " + std::to_string(bpp) +
+               " bpp, " + std::to_string(rows) + " rows per block";
+    };
+    if (header_.width != device_info.width || header_.height != device_info.height ||
+        header_.bits_per_pixel != device_info.bits_per_pixel ||
+        header_.rows_per_block != device_info.rows_per_block) {
+        return "compiled for " +
+               panel(header_.width, header_.height, header_.bits_per_pixel, header_.rows_per_block) +
+               ", card is " +
+               panel(device_info.width, device_info.height, device_info.bits_per_pixel,
+                     device_info.rows_per_block);
+    }
+    if (header_.packed_size != (size_t)device_info.fb_total_bytes()) {
+        return "framebuffer size " + std::to_string(header_.packed_size) + " does not match the card's " +
+               std::to_string(device_info.fb_total_bytes());
+    }
+    if (header_.max_fragment_data > device_info.max_fragment_data) {
+        return "compiled for " + std::to_string(header_.max_fragment_data) +
+               "-byte fragments, this link takes " + std::to_string(device_info.max_fragment_data) +
+               " (recompile with a smaller --frame-size)";
+    }
+    return "";
+}
+
+void EpdFile::check(const DeviceInfo& device_info) const {
+    std::string why = mismatch(device_info);
+    if (!why.empty()) {
+        throw std::runtime_error("Refusing " + path_ + ": " + why);
+    }
+}
+
+const uint8_t* EpdFile::verified(const Extent& extent, const char* what) const {
+    const uint8_t* p = data_ + extent.offset;
+    if (fnv1a64(p, extent.size) != extent.checksum) {
+        throw std::runtime_error("Precompiled image " + std::string(what) + " checksum mismatch: " + path_);
+    }
+    return p;
+}
+
+std::vector<Apdu> EpdFile::block(int index) const {
+    const Extent& extent = blocks_.at(index);
+    ByteReader r(verified(extent, "block"), extent.size);
+    auto apdus = read_apdu_block(r);
+    if (!r.at_end()) {
+        throw std::runtime_error("Precompiled image block " + std::to_string(index) +
+                                 " is inconsistent: " + path_);
+    }
+    return apdus;
+}
+
+std::vector<uint8_t> EpdFile::packed() const {
+    const uint8_t* p = verified(packed_, "framebuffer");
+    return std::vector<uint8_t>(p, p + packed_.size);
+}
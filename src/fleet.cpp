@@ -0,0 +1,243 @@
+#include "fleet.hpp"
+#include "epd_file.hpp"
+#include "nfc_eink.hpp"
+
+#include <iostream>
+#include <sstream>
+
+FleetScheduler::FleetScheduler(ReaderLister list_readers, TransportFactory open_reader,
+                               FleetOptions options)
+    : list_readers_(std::move(list_readers)), open_reader_(std::move(open_reader)),
+      options_(std::move(options)) {}
+
+FleetScheduler::~FleetScheduler() {
+    remaining_ = 0;
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+void FleetScheduler::add_job(FleetJob job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FleetResult result;
+    result.image_path = job.image_path;
+    results_.push_back(result);
+    pending_.push_back({pending_.size(), std::move(job)});
+}
+
+std::vector<FleetResult> FleetScheduler::run() {
+    remaining_ = pending_.size();
+    if (pending_.empty()) return results_;
+
+    discover();
+    if (workers_.empty()) {
+        log("", "No readers attached; waiting for one to be plugged in");
+        queue_.add_lane();  // Holds the jobs until a worker steals them
+    }
+
+    // Spread the jobs over the readers found now; readers added later steal
+    size_t lanes = queue_.lane_count();
+    for (size_t i = 0; i < pending_.size(); i++) {
+        queue_.push(std::move(pending_[i]), i % lanes);
+    }
+    pending_.clear();
+
+    // Hotplug: enumerate again until every job is done
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait_for(lock, options_.hotplug_interval, [&] { return remaining_ == 0; });
+        }
+        if (remaining_ == 0) break;
+        discover();
+    }
+
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return results_;
+}
+
+std::map<std::string, int> FleetScheduler::cards_per_reader() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return served_;
+}
+
+void FleetScheduler::discover() {
+    std::vector<std::string> ids;
+    try {
+        ids = list_readers_();
+    } catch (const std::exception& e) {
+        log("", std::string("Reader enumeration failed: ") + e.what());
+        return;
+    }
+
+    for (const auto& id : ids) {
+        // A reader whose worker stopped (e.g. it was unplugged) gets a new one,
+        // which keeps the old lane
+        size_t lane = SIZE_MAX;
+        bool running = false;
+        for (auto it = workers_.begin(); it != workers_.end(); ++it) {
+            if ((*it)->reader_id != id) continue;
+            if (!(*it)->finished) {
+                running = true;
+                break;
+            }
+            (*it)->thread.join();
+            lane = (*it)->lane;
+            workers_.erase(it);
+            break;
+        }
+        if (running) continue;
+
+        auto worker = std::make_unique<Worker>();
+        worker->reader_id = id;
+        worker->lane = lane != SIZE_MAX ? lane : queue_.add_lane();
+        Worker* w = worker.get();
+        worker->thread = std::thread([this, w] { serve(*w); });
+        workers_.push_back(std::move(worker));
+    }
+}
+
+void FleetScheduler::serve(Worker& worker) {
+    const std::string& id = worker.reader_id;
+    try {
+        NfcEinkCard card(open_reader_(id));
+        card.set_quiet(true);
+        card.open_reader();
+        log(id, "ready");
+
+        // Serial of the card served during its current visit
+        std::string served;
+        while (remaining_ > 0) {
+            if (!card.wait_for_card(options_.card_poll)) {
+                served.clear();  // The card left
+                continue;
+            }
+            const std::string serial = card.device_info().serial_number;
+            if (serial == served) {
+                std::this_thread::sleep_for(options_.card_poll);
+                continue;
+            }
+
+            auto task = queue_.pop(worker.lane);
+            if (!task) {
+                // The remaining jobs are in flight on other readers (they may come back)
+                std::this_thread::sleep_for(options_.card_poll);
+                continue;
+            }
+
+            // Success or not, this card is done for this visit; a retry goes to the next one
+            served = serial;
+            if (upload(card, *task, worker)) {
+                finish();
+                continue;
+            }
+            int attempts;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                attempts = results_[task->index].attempts;
+            }
+            if (attempts >= options_.max_attempts) {
+                finish();
+            } else {
+                queue_.push_front(std::move(*task), worker.lane);
+            }
+        }
+    } catch (const std::exception& e) {
+        log(id, std::string("reader stopped: ") + e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    worker.finished = true;
+    changed_.notify_all();
+}
+
+bool FleetScheduler::upload(NfcEinkCard& card, Task& task, const Worker& worker) {
+    const std::string& reader_id = worker.reader_id;
+    const auto& info = card.device_info();
+    const std::string& path = task.job.image_path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& result = results_[task.index];
+        result.attempts++;
+        result.reader_id = reader_id;
+        result.serial_number = info.serial_number;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed_ms = [&] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    try {
+        // Same bookkeeping as a single upload: the record is only valid after refresh
+        if (options_.card_state) options_.card_state->forget(info.serial_number);
+        card.pacer() = FragmentPacer(options_.pacing ? options_.pacing->load(info)
+                                                     : std::chrono::microseconds(0));
+        auto sent = render_and_send(card, path.c_str(), options_.render, options_.cache);
+        if (options_.pacing) options_.pacing->save(info, card.pacer().delay());
+        // The panel refreshes on its own; meanwhile encode this reader's next job
+        auto expected = options_.refresh_times ? options_.refresh_times->predict(info)
+                                               : std::chrono::milliseconds(0);
+        auto refreshing = card.refresh_async(expected);
+        prepare_next(worker, info);
+        auto refreshed = refreshing.get();
+        if (options_.refresh_times) options_.refresh_times->record(info, refreshed.ms);
+        if (options_.card_state) options_.card_state->save(info, sent.packed());
+
+        double ms = elapsed_ms();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& result = results_[task.index];
+            result.ok = true;
+            result.error.clear();
+            result.ms = ms;
+            served_[reader_id]++;
+        }
+        std::ostringstream msg;
+        msg << info.serial_number << " <- " << path << " (" << (int)ms << " ms"
+            << (sent.cache_hit ? ", cached" : "") << ")";
+        log(reader_id, msg.str());
+        return true;
+    } catch (const std::exception& e) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& result = results_[task.index];
+            result.error = e.what();
+            result.ms = elapsed_ms();
+        }
+        log(reader_id, info.serial_number + " failed: " + e.what());
+        return false;
+    }
+}
+
+void FleetScheduler::prepare_next(const Worker& worker, const DeviceInfo& device_info) {
+    if (!options_.cache) return;
+    auto next = queue_.peek(worker.lane);
+    // .epd files need no preparation: they are read from their mapping as they are sent
+    if (!next || is_epd_file(next->job.image_path.c_str())) return;
+    // Readers usually see one panel model, so the next card most likely shares this
+    // geometry; if it does not, the entry is simply not used
+    try {
+        render_encoded(next->job.image_path.c_str(), device_info, options_.render, options_.cache);
+    } catch (const std::exception&) {
+        // Reported when the job itself runs
+    }
+}
+
+void FleetScheduler::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    remaining_--;
+    changed_.notify_all();
+}
+
+void FleetScheduler::log(const std::string& reader_id, const std::string& message) {
+    if (!options_.verbose) return;
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    if (reader_id.empty()) {
+        std::cout << message << std::endl;
+    } else {
+        std::cout << "[" << reader_id << "] " << message << std::endl;
+    }
+}
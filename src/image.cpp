@@ -1,52 +1,91 @@
 #include "image.hpp"
+#include "metrics.hpp"
 #include <lzo/lzo1x.h>
+#include <cmath>
 #include <cstring>
 #include <stdexcept>
 #include <algorithm>
+#include <limits>
+#include <mutex>
 
 static const int MAX_FRAGMENT_DATA = 250;
 
-std::vector<uint8_t> pack_row(const std::vector<int>& pixels, int bits_per_pixel) {
+void pack_row(const uint8_t* pixels, int width, int bits_per_pixel, uint8_t* out) {
     int ppb = 8 / bits_per_pixel;  // pixels per byte
-    int width = (int)pixels.size();
     int bytes_per_row = width / ppb;
-    std::vector<uint8_t> row_bytes(bytes_per_row, 0);
 
     for (int byte_idx = 0; byte_idx < bytes_per_row; byte_idx++) {
         int pixel_offset = (bytes_per_row - 1 - byte_idx) * ppb;
         uint8_t val = 0;
         for (int i = 0; i < ppb; i++) {
-            val |= static_cast<uint8_t>(pixels[pixel_offset + i]) << (i * bits_per_pixel);
+            val |= static_cast<uint8_t>(pixels[pixel_offset + i] << (i * bits_per_pixel));
         }
-        row_bytes[byte_idx] = val;
+        out[byte_idx] = val;
     }
-
-    return row_bytes;
 }
 
-std::vector<uint8_t> pack_pixels(const std::vector<std::vector<int>>& pixels, int bits_per_pixel) {
-    std::vector<uint8_t> result;
-    for (const auto& row : pixels) {
-        auto packed_row = pack_row(row, bits_per_pixel);
-        result.insert(result.end(), packed_row.begin(), packed_row.end());
+std::vector<uint8_t> pack_pixels(const Framebuffer& pixels, int bits_per_pixel) {
+    static Histogram& pack_time = stage_histogram("pack");
+    ScopedTimer timer(pack_time);
+    int bytes_per_row = pixels.width() / (8 / bits_per_pixel);
+    std::vector<uint8_t> result((size_t)bytes_per_row * pixels.height());
+    for (int y = 0; y < pixels.height(); y++) {
+        pack_row(pixels.row(y), pixels.width(), bits_per_pixel, result.data() + (size_t)y * bytes_per_row);
     }
     return result;
 }
 
-/// Rotate a 2D pixel array 90 degrees clockwise.
-/// Input shape: (H, W) -> Output shape: (W, H)
-std::vector<std::vector<int>> rotate_cw90(const std::vector<std::vector<int>>& pixels) {
-    int h = (int)pixels.size();
-    int w = (int)pixels[0].size();
-    std::vector<std::vector<int>> rotated(w, std::vector<int>(h));
+Framebuffer rotate_cw90(const Framebuffer& pixels) {
+    int h = pixels.height();
+    int w = pixels.width();
+    Framebuffer rotated(h, w);
     for (int r = 0; r < w; r++) {
+        uint8_t* out = rotated.row(r);
         for (int c = 0; c < h; c++) {
-            rotated[r][c] = pixels[h - 1 - c][r];
+            out[c] = pixels.at(r, h - 1 - c);
         }
     }
     return rotated;
 }
 
+FramebufferPacker::FramebufferPacker(const DeviceInfo& device_info)
+    : width_(device_info.width), height_(device_info.height),
+      bpp_(device_info.bits_per_pixel), ppb_(device_info.pixels_per_byte()),
+      fb_bytes_per_row_(device_info.fb_bytes_per_row()),
+      rotated_(device_info.rotated()),
+      packed_(device_info.fb_total_bytes(), 0) {}
+
+size_t FramebufferPacker::complete_bytes() const {
+    if (rotated_) return rows_written_ >= height_ ? packed_.size() : 0;
+    return (size_t)std::min(rows_written_, height_) * fb_bytes_per_row_;
+}
+
+void FramebufferPacker::write_row(int y, const uint8_t* indices) {
+    rows_written_++;
+    if (!rotated_) {
+        pack_row(indices, width_, bpp_, packed_.data() + (size_t)y * fb_bytes_per_row_);
+        return;
+    }
+
+    // Rotated 90° CW: panel pixel (x, y) lands at framebuffer row x, column h-1-y
+    int c = height_ - 1 - y;
+    int byte_idx = fb_bytes_per_row_ - 1 - c / ppb_;
+    int shift = (c % ppb_) * bpp_;
+    uint8_t mask = (uint8_t)~(((1 << bpp_) - 1) << shift);
+    uint8_t* dst = packed_.data() + byte_idx;
+    for (int x = 0; x < width_; x++, dst += fb_bytes_per_row_) {
+        *dst = (uint8_t)((*dst & mask) | (indices[x] << shift));
+    }
+}
+
+std::vector<uint8_t> pack_framebuffer(const Framebuffer& pixels, const DeviceInfo& device_info) {
+    FramebufferPacker packer(device_info);
+    for (int y = 0; y < pixels.height(); y++) {
+        packer.write_row(y, pixels.row(y));
+    }
+    return packer.take();
+}
+
 std::vector<std::vector<uint8_t>> split_blocks(const std::vector<uint8_t>& packed,
                                                 const std::vector<int>& block_sizes) {
     std::vector<std::vector<uint8_t>> blocks;
@@ -59,66 +98,246 @@ std::vector<std::vector<uint8_t>> split_blocks(const std::vector<uint8_t>& packe
     return blocks;
 }
 
-std::vector<uint8_t> compress_block(const std::vector<uint8_t>& block) {
+std::vector<int> changed_blocks(const std::vector<uint8_t>& previous,
+                                const std::vector<uint8_t>& packed,
+                                const DeviceInfo& device_info) {
+    auto sizes = device_info.block_sizes();
+    std::vector<int> changed;
+    bool comparable = previous.size() == packed.size();
+    size_t offset = 0;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        size_t end = std::min(offset + sizes[i], packed.size());
+        if (!comparable || !std::equal(packed.begin() + offset, packed.begin() + end,
+                                       previous.begin() + offset)) {
+            changed.push_back((int)i);
+        }
+        offset = end;
+    }
+    return changed;
+}
+
+// --- Compression ---
+
+LzoLevel parse_lzo_level(const std::string& name) {
+    if (name == "fast") return LzoLevel::Fast;
+    if (name == "best") return LzoLevel::Best;
+    if (name == "smallest") return LzoLevel::Smallest;
+    if (name == "auto") return LzoLevel::Auto;
+    throw std::runtime_error("Unknown LZO level: " + name);
+}
+
+const char* lzo_level_name(LzoLevel level) {
+    switch (level) {
+    case LzoLevel::Fast: return "fast";
+    case LzoLevel::Best: return "best";
+    case LzoLevel::Smallest: return "smallest";
+    case LzoLevel::Auto: return "auto";
+    }
+    return "?";
+}
+
+// One LZO1X encoder run; 999_level 0 selects lzo1x_1
+static std::vector<uint8_t> lzo_compress(const uint8_t* data, size_t size, int level_999) {
+    // Blocks may be compressed on several threads at once
+    static std::once_flag once;
     static bool initialized = false;
+    std::call_once(once, [] { initialized = lzo_init() == LZO_E_OK; });
     if (!initialized) {
-        if (lzo_init() != LZO_E_OK) {
-            throw std::runtime_error("LZO initialization failed");
-        }
-        initialized = true;
+        throw std::runtime_error("LZO initialization failed");
     }
 
-    std::vector<uint8_t> wrkmem(LZO1X_1_MEM_COMPRESS, 0);
-    lzo_uint out_len = block.size() + block.size() / 16 + 64 + 3;
+    lzo_uint out_len = size + size / 16 + 64 + 3;
     std::vector<uint8_t> out(out_len);
 
-    int ret = lzo1x_1_compress(
-        block.data(), (lzo_uint)block.size(),
-        out.data(), &out_len,
-        wrkmem.data()
-    );
-
+    // Work memory is scratch space for the match dictionary: allocate once per thread
+    int ret;
+    if (level_999 == 0) {
+        thread_local std::vector<uint8_t> wrkmem(LZO1X_1_MEM_COMPRESS);
+        ret = lzo1x_1_compress(data, (lzo_uint)size, out.data(), &out_len, wrkmem.data());
+    } else {
+        thread_local std::vector<uint8_t> wrkmem(LZO1X_999_MEM_COMPRESS);
+        ret = lzo1x_999_compress_level(data, (lzo_uint)size, out.data(), &out_len, wrkmem.data(),
+                                       nullptr, 0, nullptr, level_999);
+    }
     if (ret != LZO_E_OK) {
         throw std::runtime_error("LZO compression failed");
     }
-
     out.resize(out_len);
     return out;
 }
 
-std::vector<std::vector<uint8_t>> make_fragments(const std::vector<uint8_t>& compressed) {
+// `fast_size`, if set, receives the lzo1x_1 output size (compressing once more only for Best)
+static std::vector<uint8_t> compress_at(const uint8_t* data, size_t size, LzoLevel level,
+                                        size_t* fast_size = nullptr) {
+    switch (level) {
+    case LzoLevel::Best:
+        if (fast_size) *fast_size = lzo_compress(data, size, 0).size();
+        return lzo_compress(data, size, 9);
+    case LzoLevel::Smallest: {
+        // Higher levels look harder but lazily; now and then a lower one wins
+        auto best = lzo_compress(data, size, 0);
+        if (fast_size) *fast_size = best.size();
+        for (int level_999 : {7, 9}) {
+            auto out = lzo_compress(data, size, level_999);
+            if (out.size() < best.size()) best.swap(out);
+        }
+        return best;
+    }
+    case LzoLevel::Fast:
+    case LzoLevel::Auto:
+        break;
+    }
+    auto out = lzo_compress(data, size, 0);
+    if (fast_size) *fast_size = out.size();
+    return out;
+}
+
+// Host cost of each level per input byte on one ~3 GHz x86 core, for framebuffer
+// data. A model rather than a measurement, so Auto settles on the same level (and
+// the same APDU bytes) on every machine and under any load.
+static double lzo_level_ns_per_byte(LzoLevel level) {
+    switch (level) {
+    case LzoLevel::Best: return 100.0;      // lzo1x_999 level 9
+    case LzoLevel::Smallest: return 165.0;  // lzo1x_1 + lzo1x_999 levels 7 and 9
+    case LzoLevel::Fast:
+    case LzoLevel::Auto:
+        break;
+    }
+    return 3.0;                             // lzo1x_1
+}
+
+LzoLevel choose_lzo_level(const uint8_t* sample, size_t size, size_t image_bytes,
+                          const CompressionOptions& options, int max_fragment_data) {
+    if (options.level != LzoLevel::Auto) return options.level;
+    if (size == 0) return LzoLevel::Fast;
+
+    double scale = (double)image_bytes / (double)size;
+    double fragment_bytes = (double)std::max(1, std::min(max_fragment_data, MAX_FRAGMENT_DATA));
+    LzoLevel chosen = LzoLevel::Fast;
+    double chosen_ms = std::numeric_limits<double>::infinity();
+    for (LzoLevel level : {LzoLevel::Fast, LzoLevel::Best, LzoLevel::Smallest}) {
+        double cpu_ms = lzo_level_ns_per_byte(level) * (double)image_bytes / 1e6;
+        // Fast is always allowed: there is nothing cheaper to fall back to
+        if (level != LzoLevel::Fast && options.cpu_budget_ms > 0 && cpu_ms > options.cpu_budget_ms) {
+            continue;
+        }
+        size_t out = compress_at(sample, size, level).size();
+        double bytes = (double)out * scale;
+        double rf_ms = (bytes * options.rf_us_per_byte +
+                        std::ceil(bytes / fragment_bytes) * options.per_fragment_us) / 1000.0;
+        if (cpu_ms + rf_ms < chosen_ms) {
+            chosen = level;
+            chosen_ms = cpu_ms + rf_ms;
+        }
+    }
+    return chosen;
+}
+
+LzoLevel resolve_lzo_level(const uint8_t* packed, size_t packed_size, const DeviceInfo& device_info,
+                           const CompressionOptions& options) {
+    if (options.level != LzoLevel::Auto) return options.level;
+    auto sizes = device_info.block_sizes();
+    if (sizes.empty()) return LzoLevel::Fast;
+    size_t sample = std::min((size_t)sizes[0], packed_size);
+    return choose_lzo_level(packed, sample, packed_size, options, device_info.max_fragment_data);
+}
+
+std::vector<uint8_t> compress_block(const std::vector<uint8_t>& block, LzoLevel level) {
+    return compress_block(block.data(), block.size(), level);
+}
+
+std::vector<uint8_t> compress_block(const uint8_t* data, size_t size, LzoLevel level) {
+    return compress_block(data, size, level, nullptr);
+}
+
+std::vector<uint8_t> compress_block(const uint8_t* data, size_t size, LzoLevel level,
+                                    size_t* fast_size) {
+    static Histogram& compress_time = stage_histogram("compress");
+    static Counter& bytes_in = Metrics::global().counter(
+        "send_epaper_compress_input_bytes_total", "Framebuffer bytes given to LZO");
+    static Counter& bytes_out = Metrics::global().counter(
+        "send_epaper_compress_output_bytes_total", "Compressed bytes produced by LZO");
+    static Histogram& ratio = Metrics::global().histogram(
+        "send_epaper_block_compression_ratio", "Compressed size over input size, per block", "",
+        {0.02, 0.05, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1});
+    ScopedTimer timer(compress_time);
+
+    auto out = compress_at(data, size, level, fast_size);
+    bytes_in.add(size);
+    bytes_out.add(out.size());
+    if (size > 0) ratio.observe((double)out.size() / (double)size);
+    return out;
+}
+
+std::vector<std::vector<uint8_t>> make_fragments(const std::vector<uint8_t>& compressed,
+                                                  int max_fragment_data) {
+    size_t step = (size_t)std::max(1, std::min(max_fragment_data, MAX_FRAGMENT_DATA));
     std::vector<std::vector<uint8_t>> fragments;
-    for (size_t i = 0; i < compressed.size(); i += MAX_FRAGMENT_DATA) {
-        size_t end = std::min(i + MAX_FRAGMENT_DATA, compressed.size());
+    for (size_t i = 0; i < compressed.size(); i += step) {
+        size_t end = std::min(i + step, compressed.size());
         fragments.emplace_back(compressed.begin() + i, compressed.begin() + end);
     }
     return fragments;
 }
 
-std::vector<std::vector<Apdu>> encode_image(const std::vector<std::vector<int>>& pixels,
-                                             const DeviceInfo& device_info) {
-    int bpp = device_info.bits_per_pixel;
-    auto bsizes = device_info.block_sizes();
+std::vector<Apdu> encode_block(const uint8_t* data, size_t size, int block_no,
+                               int max_fragment_data, LzoLevel level, size_t* fast_fragments) {
+    size_t fast_size = 0;
+    auto compressed = compress_block(data, size, level, fast_fragments ? &fast_size : nullptr);
+    auto fragments = make_fragments(compressed, max_fragment_data);
+    if (fast_fragments) {
+        size_t step = (size_t)std::max(1, std::min(max_fragment_data, MAX_FRAGMENT_DATA));
+        *fast_fragments = (fast_size + step - 1) / step;
+    }
+    if (fragments.size() > 256) {
+        throw std::runtime_error("Block needs more than 256 fragments");
+    }
 
-    // Rotate pixels 90° CW for rotated panels (e.g. 296×128)
-    auto effective_pixels = device_info.rotated() ? rotate_cw90(pixels) : pixels;
+    std::vector<Apdu> block_apdus;
+    for (size_t frag_no = 0; frag_no < fragments.size(); frag_no++) {
+        bool is_final = (frag_no == fragments.size() - 1);
+        block_apdus.push_back(build_image_data_apdu(block_no, (int)frag_no, fragments[frag_no], is_final));
+    }
+    return block_apdus;
+}
 
-    auto packed = pack_pixels(effective_pixels, bpp);
-    auto blocks = split_blocks(packed, bsizes);
+// Start of each block in the packed framebuffer
+static std::vector<size_t> block_offsets(const std::vector<int>& sizes) {
+    std::vector<size_t> offsets(sizes.size());
+    for (size_t i = 1; i < sizes.size(); i++) {
+        offsets[i] = offsets[i - 1] + sizes[i - 1];
+    }
+    return offsets;
+}
 
-    std::vector<std::vector<Apdu>> all_apdus;
+std::vector<std::vector<Apdu>> encode_packed(const std::vector<uint8_t>& packed,
+                                              const DeviceInfo& device_info,
+                                              ThreadPool* pool,
+                                              const CompressionOptions& compression) {
+    auto sizes = device_info.block_sizes();
+    auto offsets = block_offsets(sizes);
 
-    for (size_t block_no = 0; block_no < blocks.size(); block_no++) {
-        auto compressed = compress_block(blocks[block_no]);
-        auto fragments = make_fragments(compressed);
+    LzoLevel level = resolve_lzo_level(packed.data(), packed.size(), device_info, compression);
 
-        std::vector<Apdu> block_apdus;
-        for (size_t frag_no = 0; frag_no < fragments.size(); frag_no++) {
-            bool is_final = (frag_no == fragments.size() - 1);
-            block_apdus.push_back(build_image_data_apdu((int)block_no, (int)frag_no, fragments[frag_no], is_final));
-        }
-        all_apdus.push_back(block_apdus);
+    // Blocks are independent; each task writes its own slot, so the order is kept
+    std::vector<std::vector<Apdu>> all_apdus(sizes.size());
+    auto encode = [&](int i) {
+        size_t end = std::min(offsets[i] + sizes[i], packed.size());
+        size_t begin = std::min(offsets[i], end);
+        all_apdus[i] = encode_block(packed.data() + begin, end - begin, i,
+                                    device_info.max_fragment_data, level);
+    };
+    if (pool && pool->workers() > 0 && sizes.size() > 1) {
+        pool->parallel_for((int)sizes.size(), encode);
+    } else {
+        for (int i = 0; i < (int)sizes.size(); i++) encode(i);
     }
-
     return all_apdus;
 }
+
+std::vector<std::vector<Apdu>> encode_image(const Framebuffer& pixels,
+                                             const DeviceInfo& device_info,
+                                             ThreadPool* pool) {
+    // Rotates pixels 90° CW for rotated panels (e.g. 296×128)
+    return encode_packed(pack_framebuffer(pixels, device_info), device_info, pool);
+}
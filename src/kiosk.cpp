@@ -0,0 +1,190 @@
+#include "kiosk.hpp"
+#include "nfc_eink.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// --- KioskJobs ---
+
+KioskJobs::KioskJobs(std::string path, std::string default_image)
+    : path_(std::move(path)), default_image_(std::move(default_image)) {
+    if (!path_.empty()) reload();
+}
+
+std::string KioskJobs::lookup(const std::string& serial_number) {
+    if (!path_.empty()) {
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path_, ec);
+        if (!ec && mtime != mtime_) reload();
+    }
+    return find(serial_number);
+}
+
+std::string KioskJobs::find(const std::string& serial_number) const {
+    auto it = jobs_.find(serial_number);
+    if (it != jobs_.end()) return it->second;
+    return file_default_.empty() ? default_image_ : file_default_;
+}
+
+void KioskJobs::reload() {
+    // Recorded before anything can fail: a broken, unreadable or vanished file is
+    // reported once, not on every lookup (a missing file records the minimum time)
+    std::error_code ec;
+    mtime_ = fs::last_write_time(path_, ec);
+
+    std::ifstream in(path_);
+    if (!in) {
+        throw std::runtime_error("Cannot open job file: " + path_);
+    }
+
+    std::map<std::string, std::string> jobs;
+    std::string file_default;
+    fs::path base = fs::path(path_).parent_path();
+    std::string line;
+    for (int line_no = 1; std::getline(in, line); line_no++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string serial;
+        if (!(fields >> serial)) continue;
+
+        // The rest of the line is the path, which may contain spaces
+        std::string image;
+        std::getline(fields >> std::ws, image);
+        while (!image.empty() && std::isspace((unsigned char)image.back())) image.pop_back();
+        if (image.empty()) {
+            throw std::runtime_error(path_ + ":" + std::to_string(line_no) + ": missing image path");
+        }
+        if (fs::path(image).is_relative()) image = (base / image).string();
+
+        if (serial == "*") {
+            file_default = image;
+        } else {
+            jobs[serial] = image;
+        }
+    }
+
+    jobs_.swap(jobs);
+    file_default_.swap(file_default);
+}
+
+// --- KioskSession ---
+
+KioskSession::KioskSession(std::unique_ptr<NfcTransport> transport, KioskJobs& jobs,
+                           KioskOptions options)
+    : card_(std::make_unique<NfcEinkCard>(std::move(transport))), jobs_(jobs),
+      options_(std::move(options)) {
+    card_->set_quiet(true);
+}
+
+KioskSession::~KioskSession() = default;
+
+KioskStats KioskSession::run() {
+    auto start = std::chrono::steady_clock::now();
+    card_->open_reader();
+    stats_.reader_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    log("Reader ready in " + std::to_string((int)stats_.reader_ms) + " ms; waiting for cards");
+
+    // Serial of the card served during its current visit
+    std::string served;
+    while (!stop_ && (options_.max_cards <= 0 || stats_.cards < options_.max_cards)) {
+        if (!card_->wait_for_card(options_.card_poll)) {
+            served.clear();  // The card left
+            continue;
+        }
+        const std::string serial = card_->device_info().serial_number;
+        if (serial == served) {
+            // The transport cannot tell when a card leaves: it is still here
+            std::this_thread::sleep_for(options_.removal_poll);
+            continue;
+        }
+
+        served = serial;
+        auto detection = card_->last_detection();
+        if (detection.polls > 0) {
+            stats_.detected++;
+            stats_.poll_cycle_ms += detection.cycle_ms;
+            stats_.activation_ms += detection.activation_ms;
+        }
+        auto visit = std::chrono::steady_clock::now();
+        serve(serial);
+        stats_.busy_ms += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - visit).count();
+
+        if (wait_for_removal()) served.clear();
+    }
+    card_->close();
+    return stats_;
+}
+
+void KioskSession::serve(const std::string& serial) {
+    stats_.cards++;
+    std::string path;
+    try {
+        path = jobs_.lookup(serial);
+    } catch (const std::exception& e) {
+        // Keep serving from the jobs loaded before
+        log(std::string("Job file not reloaded: ") + e.what());
+        path = jobs_.find(serial);
+    }
+    if (path.empty()) {
+        stats_.no_job++;
+        log(serial + ": no job for this card");
+        return;
+    }
+    if (upload(path)) {
+        stats_.uploads++;
+    } else {
+        stats_.failures++;
+    }
+}
+
+bool KioskSession::upload(const std::string& path) {
+    const auto& info = card_->device_info();
+    auto start = std::chrono::steady_clock::now();
+    try {
+        // Same bookkeeping as a single upload: the record is only valid after refresh
+        if (options_.card_state) options_.card_state->forget(info.serial_number);
+        card_->pacer() = FragmentPacer(options_.pacing ? options_.pacing->load(info)
+                                                       : std::chrono::microseconds(0));
+        auto sent = render_and_send(*card_, path.c_str(), options_.render, options_.cache);
+        if (options_.pacing) options_.pacing->save(info, card_->pacer().delay());
+        auto expected = options_.refresh_times ? options_.refresh_times->predict(info)
+                                               : std::chrono::milliseconds(0);
+        auto refreshed = card_->refresh_async(expected).get();
+        if (options_.refresh_times) options_.refresh_times->record(info, refreshed.ms);
+        if (options_.card_state) options_.card_state->save(info, sent.packed());
+
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        std::ostringstream msg;
+        msg << info.serial_number << " <- " << path << " (" << (int)ms << " ms"
+            << (sent.cache_hit ? ", cached" : "") << ")";
+        log(msg.str());
+        return true;
+    } catch (const std::exception& e) {
+        log(info.serial_number + " failed: " + e.what());
+        return false;
+    }
+}
+
+// True if the card was seen on the reader and then left; false if the transport
+// cannot tell (the serial check in run() then keeps the card from being served twice)
+bool KioskSession::wait_for_removal() {
+    bool seen = false;
+    while (!stop_ && card_->card_present()) {
+        seen = true;
+        std::this_thread::sleep_for(options_.removal_poll);
+    }
+    return seen;
+}
+
+void KioskSession::log(const std::string& message) {
+    if (options_.verbose) std::cout << message << std::endl;
+}
@@ -0,0 +1,215 @@
+#include "metrics.hpp"
+#include "byte_io.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+// --- Histogram ---
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)), counts_(new std::atomic<uint64_t>[bounds_.size() + 1]) {
+    std::sort(bounds_.begin(), bounds_.end());
+    for (size_t i = 0; i <= bounds_.size(); i++) counts_[i] = 0;
+}
+
+void Histogram::observe(double value) {
+    size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    double sum = sum_.load(std::memory_order_relaxed);
+    while (!sum_.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {}
+    double min = min_.load(std::memory_order_relaxed);
+    while (value < min && !min_.compare_exchange_weak(min, value, std::memory_order_relaxed)) {}
+    double max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot s;
+    s.bounds = bounds_;
+    s.counts.resize(bounds_.size() + 1);
+    for (size_t i = 0; i <= bounds_.size(); i++) {
+        s.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        s.count += s.counts[i];
+    }
+    s.sum = sum_.load(std::memory_order_relaxed);
+    s.min = s.count ? min_.load(std::memory_order_relaxed) : 0.0;
+    s.max = max_.load(std::memory_order_relaxed);
+    return s;
+}
+
+double Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) return 0.0;
+    double rank = q * (double)count;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        if (counts[i] == 0 || (double)(seen + counts[i]) < rank) {
+            seen += counts[i];
+            continue;
+        }
+        // Linear within the bucket, narrowed to the smallest and largest values seen
+        double lo = std::max(i == 0 ? 0.0 : bounds[i - 1], min);
+        double hi = i < bounds.size() ? std::min(bounds[i], max) : max;
+        lo = std::min(lo, hi);
+        return lo + (hi - lo) * (rank - (double)seen) / (double)counts[i];
+    }
+    return max;
+}
+
+// --- Metrics ---
+
+Metrics& Metrics::global() {
+    static Metrics metrics;
+    return metrics;
+}
+
+std::vector<double> Metrics::time_buckets() {
+    std::vector<double> bounds;
+    for (double b = 50e-6; b < 120.0; b *= 2) bounds.push_back(b);
+    return bounds;
+}
+
+Metrics::Family& Metrics::family(const std::string& name, const std::string& help, const char* type) {
+    auto& f = families_[name];
+    if (f.type.empty()) {
+        f.help = help;
+        f.type = type;
+    }
+    return f;
+}
+
+Counter& Metrics::counter(const std::string& name, const std::string& help,
+                          const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = family(name, help, "counter").counters[labels];
+    if (!slot) slot = std::make_unique<Counter>();
+    return *slot;
+}
+
+Histogram& Metrics::histogram(const std::string& name, const std::string& help,
+                              const std::string& labels, const std::vector<double>& bounds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = family(name, help, "histogram").histograms[labels];
+    if (!slot) slot = std::make_unique<Histogram>(bounds);
+    return *slot;
+}
+
+static std::string series_name(const std::string& name, const std::string& labels) {
+    return labels.empty() ? name : name + "{" + labels + "}";
+}
+
+static std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static std::string number(double v) {
+    std::ostringstream out;
+    out << std::setprecision(9) << (std::isfinite(v) ? v : 0.0);
+    return out.str();
+}
+
+std::string Metrics::json() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    const char* sep = "";
+
+    out << "{\n  \"counters\": {";
+    uint64_t compress_in = 0, compress_out = 0;
+    for (const auto& [name, f] : families_) {
+        for (const auto& [labels, c] : f.counters) {
+            uint64_t v = c->value();
+            if (name == "send_epaper_compress_input_bytes_total") compress_in += v;
+            if (name == "send_epaper_compress_output_bytes_total") compress_out += v;
+            out << sep << "\n    " << json_string(series_name(name, labels)) << ": " << v;
+            sep = ",";
+        }
+    }
+
+    out << "\n  },\n  \"histograms\": {";
+    sep = "";
+    for (const auto& [name, f] : families_) {
+        for (const auto& [labels, h] : f.histograms) {
+            auto s = h->snapshot();
+            out << sep << "\n    " << json_string(series_name(name, labels)) << ": {"
+                << "\"count\": " << s.count << ", \"sum\": " << number(s.sum)
+                << ", \"mean\": " << number(s.count ? s.sum / (double)s.count : 0.0)
+                << ", \"p50\": " << number(s.quantile(0.5))
+                << ", \"p90\": " << number(s.quantile(0.9))
+                << ", \"p99\": " << number(s.quantile(0.99))
+                << ", \"max\": " << number(s.max) << "}";
+            sep = ",";
+        }
+    }
+
+    out << "\n  },\n  \"ratios\": {\n    \"compression\": "
+        << number(compress_in ? (double)compress_out / (double)compress_in : 0.0) << "\n  }\n}\n";
+    return out.str();
+}
+
+std::string Metrics::prometheus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    for (const auto& [name, f] : families_) {
+        out << "# HELP " << name << " " << f.help << "\n";
+        out << "# TYPE " << name << " " << f.type << "\n";
+        for (const auto& [labels, c] : f.counters) {
+            out << series_name(name, labels) << " " << c->value() << "\n";
+        }
+        for (const auto& [labels, h] : f.histograms) {
+            auto s = h->snapshot();
+            std::string prefix = labels.empty() ? "" : labels + ",";
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < s.counts.size(); i++) {
+                cumulative += s.counts[i];
+                std::string le = i < s.bounds.size() ? number(s.bounds[i]) : "+Inf";
+                out << name << "_bucket{" << prefix << "le=\"" << le << "\"} " << cumulative << "\n";
+            }
+            out << series_name(name + "_sum", labels) << " " << number(s.sum) << "\n";
+            out << series_name(name + "_count", labels) << " " << s.count << "\n";
+        }
+    }
+    return out.str();
+}
+
+bool Metrics::write_textfile(const std::string& path) const {
+    std::string text = prometheus();
+    return write_file_atomic(path, std::vector<uint8_t>(text.begin(), text.end()));
+}
+
+Histogram& stage_histogram(const std::string& stage) {
+    return Metrics::global().histogram(
+        "send_epaper_stage_seconds",
+        "Time per image in each step of the image pipeline (per block for compress)",
+        "stage=\"" + stage + "\"");
+}
+
+// --- MetricsTextfileWriter ---
+
+MetricsTextfileWriter::MetricsTextfileWriter(std::string path, std::chrono::seconds interval,
+                                             Metrics& metrics)
+    : path_(std::move(path)), interval_(interval), metrics_(metrics) {
+    thread_ = std::thread([this] {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            wake_.wait_for(lock, interval_, [this] { return stop_; });
+            metrics_.write_textfile(path_);
+        }
+    });
+}
+
+MetricsTextfileWriter::~MetricsTextfileWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
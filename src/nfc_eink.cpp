@@ -1,74 +1,279 @@
 #include "nfc_eink.hpp"
 #include "image.hpp"
+#include "metrics.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
 
+// Attempts per block before an upload is abandoned
+static const int MAX_BLOCK_ATTEMPTS = 4;
+
 NfcEinkCard::NfcEinkCard()
     : transport_(create_nfc_transport()) {}
 
+NfcEinkCard::NfcEinkCard(std::unique_ptr<NfcTransport> transport)
+    : transport_(std::move(transport)) {}
+
 NfcEinkCard::~NfcEinkCard() {
     close();
 }
 
 void NfcEinkCard::connect() {
     transport_->open();
+    identify();
+}
+
+void NfcEinkCard::open_reader() {
+    transport_->open_reader();
+}
+
+bool NfcEinkCard::wait_for_card(std::chrono::milliseconds timeout) {
+    if (!transport_->wait_for_card(timeout)) return false;
+    identify();
+    return true;
+}
+
+// --- Metrics ---
+
+namespace {
+
+struct CardMetrics {
+    Histogram& apdu_time;
+    Counter& apdus;
+    Counter& apdu_errors;
+    Counter& bytes_sent;
+    Counter& bytes_received;
+    Histogram& refresh_time;
+    Counter& refresh_polls;
+    Histogram& poll_cycle;
+    Histogram& activation;
+    Counter& detection_polls;
+};
+
+CardMetrics& card_metrics() {
+    auto& m = Metrics::global();
+    static CardMetrics metrics{
+        m.histogram("send_epaper_apdu_seconds", "Round trip of one APDU through the transport"),
+        m.counter("send_epaper_apdus_total", "APDUs sent to cards"),
+        m.counter("send_epaper_apdu_errors_total", "APDUs that failed in the transport or card"),
+        m.counter("send_epaper_apdu_bytes_total", "APDU bytes exchanged", "direction=\"sent\""),
+        m.counter("send_epaper_apdu_bytes_total", "APDU bytes exchanged", "direction=\"received\""),
+        m.histogram("send_epaper_refresh_seconds", "From refresh command to the poll that saw it done"),
+        m.counter("send_epaper_refresh_polls_total", "Busy polls while displays refreshed"),
+        m.histogram("send_epaper_detect_poll_cycle_seconds", "One sense cycle while waiting for a card"),
+        m.histogram("send_epaper_detect_activation_seconds", "Card answer to ISO-DEP activation"),
+        m.counter("send_epaper_detect_polls_total", "Sense cycles until a card answered"),
+    };
+    return metrics;
+}
+
+void record_detection(const CardDetection& detection) {
+    if (detection.polls <= 0) return;
+    auto& m = card_metrics();
+    m.detection_polls.add(detection.polls);
+    m.poll_cycle.observe(detection.cycle_ms / 1000.0);
+    m.activation.observe(detection.activation_ms / 1000.0);
+}
+
+}  // namespace
+
+std::vector<uint8_t> NfcEinkCard::transmit(const Apdu& apdu) {
+    auto& m = card_metrics();
+    m.apdus.add();
+    m.bytes_sent.add(4 + (apdu.has_data ? 1 + apdu.data.size() : 0) + (apdu.le >= 0 ? 1 : 0));
+    ScopedTimer timer(m.apdu_time);
+    try {
+        auto response = transport_->send_apdu(apdu);
+        m.bytes_received.add(response.size());
+        return response;
+    } catch (...) {
+        m.apdu_errors.add();
+        throw;
+    }
+}
+
+void NfcEinkCard::identify() {
+    record_detection(transport_->last_detection());
 
     // Authenticate
     auto auth_apdu = build_auth_apdu();
-    transport_->send_apdu(auth_apdu);
+    transmit(auth_apdu);
 
     // Read device info
     auto info_apdu = build_device_info_apdu();
-    auto response = transport_->send_apdu(info_apdu);
+    auto response = transmit(info_apdu);
     device_info_ = parse_device_info(response);
 
-    std::cout << "Card: " << device_info_.serial_number
+    // One fragment per I-block: no chaining on small frames, no split APDU on large ones
+    if (int max_apdu = transport_->max_unchained_apdu()) {
+        device_info_.max_fragment_data = fragment_payload_for(max_apdu);
+    }
+
+    out() << "Card: " << device_info_.serial_number
               << " (" << device_info_.width << "x" << device_info_.height
               << ", " << device_info_.num_colors() << " colors)" << std::endl;
 }
 
+std::ostream& NfcEinkCard::out() const {
+    // A stream without a buffer discards everything written to it
+    thread_local std::ostream discard(nullptr);
+    return quiet_ ? discard : std::cout;
+}
+
 void NfcEinkCard::close() {
     if (transport_) {
         transport_->close();
     }
 }
 
-void NfcEinkCard::send_image(const std::vector<std::vector<int>>& pixels) {
-    auto all_apdus = encode_image(pixels, device_info_);
-    std::cout << "Sending image (" << all_apdus.size() << " blocks)..." << std::endl;
+void NfcEinkCard::send_image(const Framebuffer& pixels) {
+    send_packed(pack_framebuffer(pixels, device_info_));
+}
+
+void NfcEinkCard::send_packed(const std::vector<uint8_t>& packed) {
+    send_encoded(encode_packed(packed, device_info_));
+}
+
+void NfcEinkCard::send_encoded(const std::vector<std::vector<Apdu>>& all_apdus) {
+    out() << "Sending image (" << all_apdus.size() << " blocks)..." << std::endl;
     
     int block_idx = 0;
     for (const auto& block_apdus : all_apdus) {
         block_idx++;
-        std::cout << "\rBlock " << block_idx << "/" << all_apdus.size() << " (" << block_apdus.size() << " fragments) " << std::flush;
-        for (const auto& apdu : block_apdus) {
-            transport_->send_apdu(apdu);
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        out() << "\rBlock " << block_idx << "/" << all_apdus.size() << " (" << block_apdus.size() << " fragments) " << std::flush;
+        send_block(block_apdus);
+    }
+    out() << std::endl;
+}
+
+void NfcEinkCard::send_stream(BoundedQueue<std::vector<Apdu>>& queue, int block_count) {
+    out() << "Sending image (" << block_count << " blocks, pipelined)..." << std::endl;
+    int block_idx = 0;
+    while (auto block_apdus = queue.pop()) {
+        block_idx++;
+        out() << "\rBlock " << block_idx << "/" << block_count << " (" << block_apdus->size() << " fragments) " << std::flush;
+        send_block(*block_apdus);
+    }
+    out() << std::endl;
+}
+
+void NfcEinkCard::send_generated(int block_count,
+                                 const std::function<std::vector<Apdu>(int)>& block) {
+    out() << "Sending image (" << block_count << " blocks)..." << std::endl;
+    for (int i = 0; i < block_count; i++) {
+        auto block_apdus = block(i);
+        out() << "\rBlock " << i + 1 << "/" << block_count << " (" << block_apdus.size() << " fragments) " << std::flush;
+        send_block(block_apdus);
+    }
+    out() << std::endl;
+}
+
+void NfcEinkCard::send_block(const std::vector<Apdu>& block_apdus) {
+    for (int attempt = 1;; attempt++) {
+        try {
+            for (const auto& apdu : block_apdus) {
+                pacer_.wait();
+                transmit(apdu);
+                pacer_.on_success(transport_->last_apdu_wtx());
+            }
+            return;
+        } catch (const ApduStatusError& e) {
+            // A refusal (e.g. 6985 for a partial upload) says nothing about pacing and
+            // would only be refused again; only "busy" means the fragment came too soon
+            if (!e.busy()) throw;
+            pacer_.on_failure();
+            if (attempt >= MAX_BLOCK_ATTEMPTS) throw;
+        } catch (const std::exception&) {
+            // Link error (timeout, lost frame). Fragment 0 restarts the block on the
+            // card, so resending it whole is safe
+            pacer_.on_failure();
+            if (attempt >= MAX_BLOCK_ATTEMPTS) throw;
         }
     }
-    std::cout << std::endl;
 }
 
-void NfcEinkCard::refresh(float timeout, float poll_interval) {
+bool NfcEinkCard::send_blocks(const std::vector<std::vector<Apdu>>& all_apdus,
+                              const std::vector<int>& indices) {
+    out() << "Sending " << indices.size() << " of " << all_apdus.size() << " blocks..." << std::endl;
+    try {
+        for (int block : indices) {
+            out() << "\rBlock " << block + 1 << "/" << all_apdus.size() << " ("
+                      << all_apdus[block].size() << " fragments) " << std::flush;
+            send_block(all_apdus[block]);
+        }
+        out() << std::endl;
+        return true;
+    } catch (const ApduStatusError& e) {
+        // Blocks are addressed independently, but a card may refuse uploads that
+        // do not cover the whole image: resend all of them. A card still busy after
+        // every retry, like a link error, would fail the full upload too.
+        if (e.busy()) throw;
+        out() << std::endl << "Partial upload rejected (" << e.what()
+                  << "), sending the full image" << std::endl;
+    }
+    send_encoded(all_apdus);
+    return false;
+}
+
+RefreshResult NfcEinkCard::refresh(float timeout, float poll_interval) {
     auto refresh_cmd = build_refresh_apdu();
-    transport_->send_apdu(refresh_cmd);
+    auto start = std::chrono::steady_clock::now();
+    transmit(refresh_cmd);
+    return wait_refresh(start, std::chrono::milliseconds(0),
+                        std::chrono::milliseconds(static_cast<int>(timeout * 1000)),
+                        std::chrono::milliseconds(static_cast<int>(poll_interval * 1000)));
+}
 
-    auto poll_cmd = build_poll_apdu();
-    auto deadline = std::chrono::steady_clock::now() +
-                    std::chrono::milliseconds(static_cast<int>(timeout * 1000));
+std::future<RefreshResult> NfcEinkCard::refresh_async(std::chrono::milliseconds expected,
+                                                      std::chrono::milliseconds timeout) {
+    // The refresh command itself is sent here, so a card that refuses it throws now
+    auto refresh_cmd = build_refresh_apdu();
+    auto start = std::chrono::steady_clock::now();
+    transmit(refresh_cmd);
+    return std::async(std::launch::async, [this, start, expected, timeout] {
+        return wait_refresh(start, expected, timeout, std::chrono::milliseconds(500));
+    });
+}
+
+RefreshResult NfcEinkCard::wait_refresh(std::chrono::steady_clock::time_point start,
+                                        std::chrono::milliseconds expected,
+                                        std::chrono::milliseconds timeout,
+                                        std::chrono::milliseconds interval) {
+    using Clock = std::chrono::steady_clock;
+    auto ms_since_start = [start](Clock::time_point t) {
+        return std::chrono::duration<double, std::milli>(t - start).count();
+    };
 
-    while (std::chrono::steady_clock::now() < deadline) {
+    // With a prediction: nothing to learn before it is nearly due, then poll
+    // tightly around it; far past it the prediction is wrong, so fall back
+    auto next = start;
+    auto tight = interval;
+    if (expected.count() > 0) {
+        next = start + expected * 85 / 100;
+        tight = std::clamp<std::chrono::milliseconds>(expected / 20, std::chrono::milliseconds(20),
+                                                      interval);
+    }
+
+    auto poll_cmd = build_poll_apdu();
+    auto deadline = start + timeout;
+    RefreshResult result;
+    while (next < deadline) {
+        std::this_thread::sleep_until(next);
+        auto polled = Clock::now();
+        result.polls++;
         try {
-            auto response = transport_->send_apdu(poll_cmd);
+            auto response = transmit(poll_cmd);
             if (is_refresh_complete(response)) {
-                return;
+                result.ms = ms_since_start(polled);
+                card_metrics().refresh_time.observe(result.ms / 1000.0);
+                card_metrics().refresh_polls.add(result.polls);
+                return result;
             }
         } catch (...) {}
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(static_cast<int>(poll_interval * 1000))
-        );
+        bool overdue = expected.count() > 0 && polled - start > expected * 2;
+        next = polled + (overdue ? interval : tight);
     }
 
     throw std::runtime_error("Screen refresh timed out");
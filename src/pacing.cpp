@@ -0,0 +1,142 @@
+#include "pacing.hpp"
+#include "byte_io.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+// Back-off bounds; the card's WTX-less processing time is a few ms at most
+static const int64_t MIN_BACKOFF_US = 500;
+static const int64_t MAX_DELAY_US = 50000;
+static const int64_t MIN_DELAY_US = 100;   // Below this, decay straight to 0
+static const int CLEAN_RUN_TO_DECAY = 16;  // Clean fragments before the delay shrinks
+
+FragmentPacer::FragmentPacer(std::chrono::microseconds initial) : delay_(0) {
+    set_delay(initial.count());
+}
+
+void FragmentPacer::set_delay(int64_t us) {
+    us = std::min(us, MAX_DELAY_US);
+    delay_ = std::chrono::microseconds(us < MIN_DELAY_US ? 0 : us);
+}
+
+void FragmentPacer::wait() {
+    if (delay_.count() <= 0) return;
+    std::this_thread::sleep_for(delay_);
+    stats_.slept_us += (double)delay_.count();
+}
+
+void FragmentPacer::on_success(int wtx) {
+    stats_.fragments++;
+    if (wtx > 0) {
+        // The card is keeping up only by asking for more time: give it room up front
+        stats_.wtx++;
+        clean_run_ = 0;
+        set_delay(std::max(MIN_BACKOFF_US, delay_.count() * 3 / 2));
+        return;
+    }
+    if (++clean_run_ >= CLEAN_RUN_TO_DECAY) {
+        clean_run_ = 0;
+        set_delay(delay_.count() - delay_.count() / 4);
+    }
+}
+
+void FragmentPacer::on_failure() {
+    stats_.failures++;
+    clean_run_ = 0;
+    set_delay(std::max(MIN_BACKOFF_US, delay_.count() * 2));
+}
+
+double FragmentPacer::saved_us(std::chrono::microseconds fixed) const {
+    return (double)fixed.count() * stats_.fragments - stats_.slept_us;
+}
+
+// --- PacingStore ---
+
+PacingStore::PacingStore(std::string path) : path_(std::move(path)) {}
+
+static std::string serial_key(const DeviceInfo& info) {
+    return "serial:" + info.serial_number;
+}
+
+static std::string panel_key(const DeviceInfo& info) {
+    return "panel:" + std::to_string(info.width) + "x" + std::to_string(info.height);
+}
+
+// "<key> <value>" lines, shared by the stores below
+static void read_values(const std::string& path, std::map<std::string, int64_t>& values) {
+    std::vector<uint8_t> bytes;
+    if (path.empty() || !read_file_bytes(path, bytes)) return;
+
+    std::istringstream in(std::string(bytes.begin(), bytes.end()));
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t space = line.rfind(' ');
+        if (space == std::string::npos) continue;
+        try {
+            values[line.substr(0, space)] = std::stoll(line.substr(space + 1));
+        } catch (const std::exception&) {
+            // Skip malformed lines
+        }
+    }
+}
+
+static void write_values(const std::string& path, const std::map<std::string, int64_t>& values) {
+    if (path.empty()) return;
+    std::string text;
+    for (const auto& [key, value] : values) {
+        text += key + " " + std::to_string(value) + "\n";
+    }
+    write_file_atomic(path, std::vector<uint8_t>(text.begin(), text.end()));
+}
+
+void PacingStore::read() {
+    if (loaded_) return;
+    loaded_ = true;
+    read_values(path_, delays_);
+}
+
+void PacingStore::write() const {
+    write_values(path_, delays_);
+}
+
+std::chrono::microseconds PacingStore::load(const DeviceInfo& device_info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    read();
+    auto it = delays_.find(serial_key(device_info));
+    if (it == delays_.end()) it = delays_.find(panel_key(device_info));
+    return std::chrono::microseconds(it == delays_.end() ? 0 : it->second);
+}
+
+void PacingStore::save(const DeviceInfo& device_info, std::chrono::microseconds delay) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    read();
+    delays_[serial_key(device_info)] = delay.count();
+    delays_[panel_key(device_info)] = delay.count();
+    write();
+}
+
+// --- RefreshTimeStore ---
+
+RefreshTimeStore::RefreshTimeStore(std::string path) : path_(std::move(path)) {}
+
+void RefreshTimeStore::read() {
+    if (loaded_) return;
+    loaded_ = true;
+    read_values(path_, times_);
+}
+
+std::chrono::milliseconds RefreshTimeStore::predict(const DeviceInfo& device_info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    read();
+    auto it = times_.find(panel_key(device_info));
+    return std::chrono::milliseconds(it == times_.end() ? 0 : it->second);
+}
+
+void RefreshTimeStore::record(const DeviceInfo& device_info, double ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    read();
+    auto& predicted = times_[panel_key(device_info)];
+    predicted = predicted > 0 ? (predicted + (int64_t)ms) / 2 : (int64_t)ms;
+    write_values(path_, times_);
+}
@@ -0,0 +1,279 @@
+#include "pipeline.hpp"
+#include "dither.hpp"
+#include "epd_file.hpp"
+#include "image.hpp"
+#include "metrics.hpp"
+
+#include "nfc_eink.hpp"
+#include "bounded_queue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+// Rows per band; ditherers that parallelize split a band into tiles
+static const int BAND_ROWS = 32;
+
+// Bump when the packing, compression or fragmenting output changes, so stale
+// cache entries are no longer hit
+static const uint32_t ENCODER_VERSION = 1;
+
+// Blocks encoded ahead of the one in flight during a pipelined send
+static const size_t PIPELINE_DEPTH = 2;
+
+/// Called after every band with the packer holding the rows rendered so far
+using BandCallback = std::function<void(const FramebufferPacker&)>;
+
+/// Pool for options.threads: the shared one (0), none (1) or a private one in `own_pool`
+static ThreadPool* select_pool(const RenderOptions& options, std::unique_ptr<ThreadPool>& own_pool) {
+    if (options.threads == 0) return &ThreadPool::shared();
+    if (options.threads == 1) return nullptr;
+    own_pool = std::make_unique<ThreadPool>(options.threads - 1);
+    return own_pool.get();
+}
+
+static std::vector<uint8_t> render_source(ImageRowSource& source, const DeviceInfo& device_info,
+                                          const RenderOptions& options,
+                                          const BandCallback& on_band = nullptr) {
+    int w = device_info.width;
+    int h = device_info.height;
+
+    std::unique_ptr<ThreadPool> own_pool;
+    ThreadPool* pool = select_pool(options, own_pool);
+
+    auto quantizer = PaletteQuantizer::shared(PALETTE_4COLOR, options.metric);
+    auto ditherer = make_row_ditherer(options.dither, w, *quantizer, pool);
+    FramebufferPacker packer(device_info);
+
+    // Steps interleave band by band: their times are summed and reported per image.
+    // The band callback is left out of render: it encodes (counted by compress) and
+    // may block on a sender that is behind.
+    using Clock = std::chrono::steady_clock;
+    static Histogram& resize_time = stage_histogram("resize");
+    static Histogram& dither_time = stage_histogram("dither");
+    static Histogram& pack_time = stage_histogram("pack");
+    static Histogram& render_time = stage_histogram("render");
+    Clock::duration resizing{}, dithering{}, packing{}, callbacks{};
+    auto start = Clock::now();
+
+    Framebuffer band(w, BAND_ROWS);
+    std::vector<uint8_t> rgb_band((size_t)w * 3 * BAND_ROWS);
+    for (int y0 = 0; y0 < h; y0 += BAND_ROWS) {
+        int rows = std::min(BAND_ROWS, h - y0);
+        auto t0 = Clock::now();
+        for (int r = 0; r < rows; r++) {
+            source.next_row(rgb_band.data() + (size_t)r * w * 3);
+        }
+        auto t1 = Clock::now();
+        ditherer->dither_rows(rgb_band.data(), rows, band.data(), band.stride());
+        auto t2 = Clock::now();
+        for (int r = 0; r < rows; r++) {
+            packer.write_row(y0 + r, band.row(r));
+        }
+        auto t3 = Clock::now();
+        resizing += t1 - t0;
+        dithering += t2 - t1;
+        packing += t3 - t2;
+        if (on_band) {
+            on_band(packer);
+            callbacks += Clock::now() - t3;
+        }
+    }
+
+    auto seconds = [](Clock::duration d) { return std::chrono::duration<double>(d).count(); };
+    resize_time.observe(seconds(resizing));
+    dither_time.observe(seconds(dithering));
+    pack_time.observe(seconds(packing));
+    render_time.observe(seconds(Clock::now() - start - callbacks));
+    return packer.take();
+}
+
+std::vector<uint8_t> render_packed(const char* path, const DeviceInfo& device_info,
+                                   const RenderOptions& options) {
+    ImageRowSource source(path, device_info.width, device_info.height, options.bg_color,
+                          options.resize_mode, options.filter);
+    return render_source(source, device_info, options);
+}
+
+std::vector<uint8_t> render_packed(const uint8_t* encoded, size_t size, const DeviceInfo& device_info,
+                                   const RenderOptions& options) {
+    ImageRowSource source(encoded, size, device_info.width, device_info.height, options.bg_color,
+                          options.resize_mode, options.filter);
+    return render_source(source, device_info, options);
+}
+
+uint64_t render_cache_key(const uint8_t* encoded, size_t size, const RenderOptions& options,
+                          const DeviceInfo& device_info) {
+    uint64_t hash = fnv1a64(encoded, size);
+    auto mix_int = [&](int64_t v) { hash = fnv1a64(&v, sizeof(v), hash); };
+    auto mix_str = [&](const std::string& s) {
+        mix_int((int64_t)s.size());
+        hash = fnv1a64(s.data(), s.size(), hash);
+    };
+
+    // options.threads is left out: parallel dithering produces identical output
+    mix_int(ENCODER_VERSION);
+    mix_int(options.bg_color.r);
+    mix_int(options.bg_color.g);
+    mix_int(options.bg_color.b);
+    mix_str(options.resize_mode);
+    mix_int((int)options.filter);
+    mix_str(options.dither);
+    mix_int((int)options.metric);
+    mix_int(device_info.width);
+    mix_int(device_info.height);
+    mix_int(device_info.bits_per_pixel);
+    mix_int(device_info.rows_per_block);
+    mix_int(device_info.max_fragment_data);
+    // Levels decode to the same pixels but send different bytes; what Auto picks
+    // depends on the costs it weighs
+    mix_int((int)options.compression.level);
+    if (options.compression.level == LzoLevel::Auto) {
+        mix_int((int64_t)(options.compression.rf_us_per_byte * 1000));
+        mix_int((int64_t)(options.compression.per_fragment_us * 1000));
+        mix_int((int64_t)(options.compression.cpu_budget_ms * 1000));
+    }
+    return hash;
+}
+
+static std::vector<uint8_t> read_file(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error(std::string("Failed to load image: ") + path);
+    }
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)),
+                                std::istreambuf_iterator<char>());
+}
+
+std::shared_ptr<const EncodedImage> render_encoded(const char* path, const DeviceInfo& device_info,
+                                                   const RenderOptions& options, ApduCache* cache) {
+    if (is_epd_file(path)) {
+        return load_epd(path, device_info);
+    }
+    // Hash and decode the same bytes, so the key always matches the rendered content
+    auto source = read_file(path);
+    return render_encoded(source.data(), source.size(), device_info, options, cache);
+}
+
+std::shared_ptr<const EncodedImage> render_encoded(const uint8_t* encoded, size_t size,
+                                                   const DeviceInfo& device_info,
+                                                   const RenderOptions& options, ApduCache* cache) {
+    uint64_t key = 0;
+    if (cache) {
+        key = render_cache_key(encoded, size, options, device_info);
+        if (auto hit = cache->find(key)) {
+            return hit;
+        }
+    }
+
+    auto image = std::make_shared<EncodedImage>();
+    image->packed = render_packed(encoded, size, device_info, options);
+    std::unique_ptr<ThreadPool> own_pool;
+    image->blocks = encode_packed(image->packed, device_info, select_pool(options, own_pool),
+                                  options.compression);
+    if (cache) {
+        cache->store(key, image);
+    }
+    return image;
+}
+
+std::vector<uint8_t> PipelinedSend::packed() const {
+    return epd ? epd->packed() : image->packed;
+}
+
+namespace {
+/// Thrown inside the producer when the consumer stopped the pipeline
+struct PipelineCancelled {};
+}  // namespace
+
+PipelinedSend render_and_send(NfcEinkCard& card, const char* path, const RenderOptions& options,
+                              ApduCache* cache) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto elapsed_ms = [&] {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    const DeviceInfo& info = card.device_info();
+    PipelinedSend result;
+    if (is_epd_file(path)) {
+        // Blocks go to the card straight from the mapping, parsed one at a time
+        auto epd = std::make_shared<const EpdFile>(path);
+        epd->check(info);
+        result.epd = epd;
+        result.precompiled = true;
+        result.first_block_ms = elapsed_ms();
+        card.send_generated(epd->header().blocks, [&](int b) { return epd->block(b); });
+        return result;
+    }
+    auto source = read_file(path);
+    uint64_t key = 0;
+    if (cache) {
+        key = render_cache_key(source.data(), source.size(), options, info);
+        if (auto hit = cache->find(key)) {
+            result.image = hit;
+            result.cache_hit = true;
+            result.first_block_ms = elapsed_ms();
+            card.send_encoded(hit->blocks);
+            return result;
+        }
+    }
+
+    auto image = std::make_shared<EncodedImage>();
+    const auto sizes = info.block_sizes();
+    image->blocks.resize(sizes.size());
+    BoundedQueue<std::vector<Apdu>> queue(PIPELINE_DEPTH);
+
+    // Producer: render; whenever the rows of the next block are final, encode and queue it
+    std::thread producer([&] {
+        try {
+            size_t next = 0, offset = 0;
+            auto emit_ready = [&](const FramebufferPacker& packer) {
+                while (next < sizes.size() && offset + sizes[next] <= packer.complete_bytes()) {
+                    // Auto is settled on the first block: later ones are not rendered yet
+                    if (next == 0) {
+                        result.lzo_level = resolve_lzo_level(packer.packed().data(), packer.packed().size(),
+                                                             info, options.compression);
+                    }
+                    size_t fast = 0;
+                    auto apdus = encode_block(packer.packed().data() + offset, sizes[next], (int)next,
+                                              info.max_fragment_data, result.lzo_level, &fast);
+                    result.fast_fragments += fast;
+                    image->blocks[next] = apdus;
+                    if (next == 0) result.first_block_ms = elapsed_ms();
+                    if (!queue.push(std::move(apdus))) throw PipelineCancelled();
+                    offset += sizes[next];
+                    next++;
+                }
+            };
+            ImageRowSource rows(source.data(), source.size(), info.width, info.height,
+                                options.bg_color, options.resize_mode, options.filter);
+            image->packed = render_source(rows, info, options, emit_ready);
+            queue.close();
+        } catch (const PipelineCancelled&) {
+            // Consumer gave up; its exception is reported instead
+        } catch (...) {
+            queue.fail(std::current_exception());
+        }
+    });
+
+    try {
+        card.send_stream(queue, (int)sizes.size());
+    } catch (...) {
+        queue.close();
+        producer.join();
+        throw;
+    }
+    producer.join();
+
+    if (cache) {
+        cache->store(key, image);
+    }
+    result.image = image;
+    return result;
+}
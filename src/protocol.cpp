@@ -1,4 +1,5 @@
 #include "protocol.hpp"
+#include <algorithm>
 #include <map>
 #include <stdexcept>
 #include <sstream>
@@ -99,3 +100,49 @@ DeviceInfo parse_device_info(const std::vector<uint8_t>& data) {
 
     return info;
 }
+
+//--- ATS ---
+
+// One elementary time unit of ISO14443 frame timing: 256 * 16 / fc, fc = 13.56 MHz
+static const double FRAME_TIME_UNIT_US = 256.0 * 16.0 / 13.56;
+
+double AtsParams::fwt_us() const {
+    return FRAME_TIME_UNIT_US * (double)(1 << fwi);
+}
+
+double AtsParams::sfgt_us() const {
+    return sfgi == 0 ? 0.0 : FRAME_TIME_UNIT_US * (double)(1 << sfgi);
+}
+
+AtsParams parse_ats(const std::vector<uint8_t>& ats) {
+    AtsParams params;
+    // TL T0 [TA] [TB] [TC] historical bytes...
+    size_t tl = ats.empty() ? 0 : std::min<size_t>(ats[0], ats.size());
+    if (tl < 2) return params;
+
+    static const int FSC_TABLE[] = {16, 24, 32, 40, 48, 64, 96, 128, 256};
+    uint8_t t0 = ats[1];
+    int fsci = t0 & 0x0F;
+    params.fsc = fsci <= 8 ? FSC_TABLE[fsci] : 256;  // RFU values are read as 256
+
+    size_t i = 2;
+    if (t0 & 0x10) i++;  // TA: bit rates, not used (106 kbps only)
+    if (t0 & 0x20) {
+        if (i >= tl) return params;
+        uint8_t tb = ats[i++];
+        params.fwi = tb >> 4;
+        params.sfgi = tb & 0x0F;
+        if (params.fwi == 15) params.fwi = 4;    // RFU: default
+        if (params.sfgi == 15) params.sfgi = 0;
+    }
+    return params;
+}
+
+int fragment_payload_for(int max_apdu) {
+    // CLA INS P1 P2 Lc | block_no frag_no payload
+    const int overhead = 5 + 2;
+    // frag_no is one byte: a 2000-byte block (worst case ~2200 compressed) must fit
+    // in 256 fragments, so tiny frames fall back to chaining rather than going lower
+    const int min_payload = 16;
+    return std::max(min_payload, std::min(250, max_apdu - overhead));
+}
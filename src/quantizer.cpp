@@ -0,0 +1,164 @@
+#include "quantizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+ColorMetric parse_color_metric(const std::string& name) {
+    if (name == "rgb") return ColorMetric::Rgb;
+    if (name == "lab") return ColorMetric::Lab;
+    throw std::runtime_error("Unknown color metric: " + name);
+}
+
+// --- sRGB -> CIELAB (D65) ---
+
+static float srgb_to_linear(int v) {
+    float c = v / 255.0f;
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float lab_f(float t) {
+    const float delta = 6.0f / 29.0f;
+    return t > delta * delta * delta ? std::cbrt(t) : t / (3 * delta * delta) + 4.0f / 29.0f;
+}
+
+static std::array<float, 3> rgb_to_lab(int r, int g, int b) {
+    static const auto linear = [] {
+        std::array<float, 256> t{};
+        for (int i = 0; i < 256; i++) t[i] = srgb_to_linear(i);
+        return t;
+    }();
+    float lr = linear[r], lg = linear[g], lb = linear[b];
+    float x = (0.4124f * lr + 0.3576f * lg + 0.1805f * lb) / 0.95047f;
+    float y = (0.2126f * lr + 0.7152f * lg + 0.0722f * lb);
+    float z = (0.0193f * lr + 0.1192f * lg + 0.9505f * lb) / 1.08883f;
+    float fx = lab_f(x), fy = lab_f(y), fz = lab_f(z);
+    return {116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz)};
+}
+
+// --- PaletteQuantizer ---
+
+PaletteQuantizer::PaletteQuantizer(const std::array<Color, 4>& palette, ColorMetric metric)
+    : palette_(palette), metric_(metric) {
+    for (size_t i = 0; i < palette_.size(); i++) {
+        palette_lab_[i] = rgb_to_lab(palette_[i].r, palette_[i].g, palette_[i].b);
+    }
+    build();
+}
+
+int PaletteQuantizer::nearest_exact(int r, int g, int b) const {
+    int best_idx = 0;
+    if (metric_ == ColorMetric::Rgb) {
+        int best_dist = INT32_MAX;
+        for (int i = 0; i < (int)palette_.size(); i++) {
+            int dr = r - palette_[i].r;
+            int dg = g - palette_[i].g;
+            int db = b - palette_[i].b;
+            int dist = dr * dr + dg * dg + db * db;
+            if (dist < best_dist) {
+                best_dist = dist;
+                best_idx = i;
+            }
+        }
+    } else {
+        auto lab = rgb_to_lab(r, g, b);
+        float best_dist = INFINITY;
+        for (int i = 0; i < (int)palette_.size(); i++) {
+            float dl = lab[0] - palette_lab_[i][0];
+            float da = lab[1] - palette_lab_[i][1];
+            float db = lab[2] - palette_lab_[i][2];
+            float dist = dl * dl + da * da + db * db;
+            if (dist < best_dist) {
+                best_dist = dist;
+                best_idx = i;
+            }
+        }
+    }
+    return best_idx;
+}
+
+void PaletteQuantizer::build() {
+    const int cells = 1 << CELL_BITS;
+    const int span = 1 << CELL_SHIFT;
+
+    // Nearest entry on a lattice at half-cell spacing (values 0, 4, ..., 252, 255).
+    // Each cell is tested at the 27 lattice points spanning it: corners, edge
+    // midpoints, face centers and center (upper corners shared with the next cell).
+    const int step = span / 2;
+    const int n = 2 * cells + 1;
+    auto at = [&](int i) { return std::min(i * step, 255); };
+    std::vector<uint8_t> lattice((size_t)n * n * n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < n; k++) {
+                lattice[((size_t)i * n + j) * n + k] = (uint8_t)nearest_exact(at(i), at(j), at(k));
+            }
+        }
+    }
+
+    lut_.assign((size_t)cells * cells * cells, 0);
+    refined_.clear();
+
+    for (int cr = 0; cr < cells; cr++) {
+        for (int cg = 0; cg < cells; cg++) {
+            for (int cb = 0; cb < cells; cb++) {
+                // Uniform if all sample points agree. Voronoi regions are convex
+                // in RGB, so agreeing corners alone already prove it there.
+                uint8_t first = lattice[((size_t)(2 * cr) * n + 2 * cg) * n + 2 * cb];
+                bool uniform = true;
+                for (int i = 2 * cr; i <= 2 * cr + 2 && uniform; i++) {
+                    for (int j = 2 * cg; j <= 2 * cg + 2 && uniform; j++) {
+                        for (int k = 2 * cb; k <= 2 * cb + 2; k++) {
+                            if (lattice[((size_t)i * n + j) * n + k] != first) {
+                                uniform = false;
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                size_t cell = ((size_t)cr << (2 * CELL_BITS)) | (cg << CELL_BITS) | cb;
+                if (uniform) {
+                    lut_[cell] = first;
+                    continue;
+                }
+
+                // Boundary cell: resolve every value exactly
+                lut_[cell] = (uint16_t)(REFINED + refined_cells());
+                int r0 = cr * span, g0 = cg * span, b0 = cb * span;
+                for (int r = 0; r < span; r++) {
+                    for (int g = 0; g < span; g++) {
+                        for (int b = 0; b < span; b++) {
+                            refined_.push_back((uint8_t)nearest_exact(r0 + r, g0 + g, b0 + b));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::shared_ptr<const PaletteQuantizer> PaletteQuantizer::shared(const std::array<Color, 4>& palette,
+                                                                 ColorMetric metric) {
+    static std::mutex mutex;
+    static std::map<std::vector<int>, std::shared_ptr<const PaletteQuantizer>> cache;
+
+    std::vector<int> key = {(int)metric};
+    for (const auto& c : palette) {
+        key.insert(key.end(), {c.r, c.g, c.b});
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = cache[key];
+    if (!entry) {
+        entry = std::make_shared<const PaletteQuantizer>(palette, metric);
+    }
+    return entry;
+}
+
+const PaletteQuantizer& default_quantizer() {
+    static const auto quantizer = PaletteQuantizer::shared(PALETTE_4COLOR, ColorMetric::Rgb);
+    return *quantizer;
+}
@@ -0,0 +1,212 @@
+#include "resample.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+ResampleFilter parse_resample_filter(const std::string& name) {
+    if (name == "nearest") return ResampleFilter::Nearest;
+    if (name == "bilinear") return ResampleFilter::Bilinear;
+    if (name == "lanczos") return ResampleFilter::Lanczos;
+    if (name == "area") return ResampleFilter::Area;
+    throw std::runtime_error("Unknown resize filter: " + name);
+}
+
+// --- Weight tables ---
+
+static double sinc(double x) {
+    if (x == 0.0) return 1.0;
+    x *= M_PI;
+    return std::sin(x) / x;
+}
+
+static double filter_support(ResampleFilter filter) {
+    switch (filter) {
+    case ResampleFilter::Bilinear: return 1.0;
+    case ResampleFilter::Lanczos: return 3.0;
+    default: return 0.5;
+    }
+}
+
+static double filter_kernel(ResampleFilter filter, double x) {
+    switch (filter) {
+    case ResampleFilter::Bilinear:
+        x = std::fabs(x);
+        return x < 1.0 ? 1.0 - x : 0.0;
+    case ResampleFilter::Lanczos:
+        return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+    case ResampleFilter::Area:
+        return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+    default:
+        return 0.0;
+    }
+}
+
+ResampleWeights compute_resample_weights(ResampleFilter filter, int in_size, int out_size) {
+    ResampleWeights w;
+    w.start.resize(out_size);
+    w.count.resize(out_size);
+
+    if (filter == ResampleFilter::Nearest) {
+        w.max_taps = 1;
+        w.weights.assign(out_size, 1.0f);
+        for (int i = 0; i < out_size; i++) {
+            w.start[i] = std::min((int)((float)i * in_size / out_size), in_size - 1);
+            w.count[i] = 1;
+        }
+        return w;
+    }
+
+    // When shrinking, stretch the kernel over the source so it also low-passes
+    double scale = (double)in_size / out_size;
+    double filter_scale = std::max(scale, 1.0);
+    double support = filter_support(filter) * filter_scale;
+    w.max_taps = (int)std::ceil(support) * 2 + 1;
+    w.weights.assign((size_t)out_size * w.max_taps, 0.0f);
+
+    for (int i = 0; i < out_size; i++) {
+        double center = (i + 0.5) * scale;
+        int lo = std::max(0, (int)(center - support + 0.5));
+        int hi = std::min(in_size, (int)(center + support + 0.5));
+        hi = std::min(hi, lo + w.max_taps);
+
+        double total = 0.0;
+        float* row = &w.weights[(size_t)i * w.max_taps];
+        for (int x = lo; x < hi; x++) {
+            double k = filter_kernel(filter, (x - center + 0.5) / filter_scale);
+            row[x - lo] = (float)k;
+            total += k;
+        }
+        if (total != 0.0) {
+            for (int k = 0; k < hi - lo; k++) row[k] = (float)(row[k] / total);
+        } else {
+            // Degenerate window (tiny images): fall back to the nearest sample
+            lo = std::min((int)center, in_size - 1);
+            hi = lo + 1;
+            row[0] = 1.0f;
+        }
+        w.start[i] = lo;
+        w.count[i] = hi - lo;
+    }
+    return w;
+}
+
+// --- Row kernels ---
+
+void premultiply_row(const uint8_t* rgba, int width, float* out) {
+    const float inv = 1.0f / 255.0f;
+    int x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x < width; x++) {
+        int v;
+        std::memcpy(&v, rgba + x * 4, 4);
+        __m128i px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+        __m128 f = _mm_cvtepi32_ps(px);
+        float a = rgba[x * 4 + 3] * inv;
+        __m128 scale = _mm_set_ps(inv, a, a, a);  // lanes: r g b a
+        _mm_storeu_ps(out + x * 4, _mm_mul_ps(f, scale));
+    }
+#elif defined(__ARM_NEON)
+    for (; x + 2 <= width; x += 2) {
+        uint16x8_t wide = vmovl_u8(vld1_u8(rgba + x * 4));
+        for (int k = 0; k < 2; k++) {
+            uint32x4_t px = vmovl_u16(k ? vget_high_u16(wide) : vget_low_u16(wide));
+            float a = rgba[(x + k) * 4 + 3] * inv;
+            const float s[4] = {a, a, a, inv};
+            vst1q_f32(out + (x + k) * 4, vmulq_f32(vcvtq_f32_u32(px), vld1q_f32(s)));
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        float a = rgba[x * 4 + 3] * inv;
+        out[x * 4 + 0] = rgba[x * 4 + 0] * a;
+        out[x * 4 + 1] = rgba[x * 4 + 1] * a;
+        out[x * 4 + 2] = rgba[x * 4 + 2] * a;
+        out[x * 4 + 3] = a;
+    }
+}
+
+void resample_row(const float* in, const ResampleWeights& weights, int x0, int x1, float* out) {
+    // One RGBA pixel is one 4-lane vector: each tap is a single multiply-add
+    for (int i = x0; i < x1; i++, out += 4) {
+        const float* src = in + (size_t)weights.start[i] * 4;
+        const float* w = &weights.weights[(size_t)i * weights.max_taps];
+        int n = weights.count[i];
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128 acc = _mm_setzero_ps();
+        for (int k = 0; k < n; k++) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + k * 4), _mm_set1_ps(w[k])));
+        }
+        _mm_storeu_ps(out, acc);
+#elif defined(__ARM_NEON)
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (int k = 0; k < n; k++) {
+            acc = vmlaq_n_f32(acc, vld1q_f32(src + k * 4), w[k]);
+        }
+        vst1q_f32(out, acc);
+#else
+        float acc[4] = {0, 0, 0, 0};
+        for (int k = 0; k < n; k++) {
+            for (int c = 0; c < 4; c++) acc[c] += src[k * 4 + c] * w[k];
+        }
+        std::copy(acc, acc + 4, out);
+#endif
+    }
+}
+
+void resample_column(const float* const* rows, const float* weights, int taps, int n, float* out) {
+    int j = 0;
+#if defined(__AVX2__)
+    for (; j + 8 <= n; j += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for (int k = 0; k < taps; k++) {
+            // Multiply then add, not FMA: needs only AVX2 and rounds like the other paths
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + j), _mm256_set1_ps(weights[k])));
+        }
+        _mm256_storeu_ps(out + j, acc);
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    for (; j + 4 <= n; j += 4) {
+        __m128 acc = _mm_setzero_ps();
+        for (int k = 0; k < taps; k++) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(rows[k] + j), _mm_set1_ps(weights[k])));
+        }
+        _mm_storeu_ps(out + j, acc);
+    }
+#elif defined(__ARM_NEON)
+    for (; j + 4 <= n; j += 4) {
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (int k = 0; k < taps; k++) {
+            acc = vmlaq_n_f32(acc, vld1q_f32(rows[k] + j), weights[k]);
+        }
+        vst1q_f32(out + j, acc);
+    }
+#endif
+    for (; j < n; j++) {
+        float acc = 0.0f;
+        for (int k = 0; k < taps; k++) acc += rows[k][j] * weights[k];
+        out[j] = acc;
+    }
+}
+
+void composite_row(const float* premul, int width, const float bg[3], uint8_t* rgb) {
+    for (int x = 0; x < width; x++) {
+        float inv_a = 1.0f - premul[x * 4 + 3];
+        for (int c = 0; c < 3; c++) {
+            float v = premul[x * 4 + c] + bg[c] * inv_a;
+            rgb[x * 3 + c] = (uint8_t)std::clamp((int)(v + 0.5f), 0, 255);
+        }
+    }
+}
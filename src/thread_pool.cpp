@@ -0,0 +1,78 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(int workers) {
+    for (int i = 0; i < workers; i++) {
+        threads_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::max(1, (int)std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push(std::move(job));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) return;
+            job = std::move(jobs_.front());
+            jobs_.pop();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) return;
+
+    // Iterations are claimed from a shared counter by every participant
+    struct State {
+        std::atomic<int> next{0};
+        std::mutex mutex;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    auto run = [state, count, &fn] {
+        for (int i; (i = state->next.fetch_add(1)) < count;) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+        }
+    };
+
+    int helpers = std::min(workers(), count - 1);
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < helpers; i++) {
+        done.push_back(submit(run));
+    }
+    run();
+    for (auto& f : done) f.wait();
+
+    if (state->error) std::rethrow_exception(state->error);
+}
@@ -0,0 +1,298 @@
+#include "transport_emulator.hpp"
+
+#include <lzo/lzo1x.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+// Status words returned by the emulated card
+static const uint16_t SW_OK                 = 0x9000;
+static const uint16_t SW_SECURITY           = 0x6982;  // Not authenticated / wrong key
+static const uint16_t SW_CONDITIONS         = 0x6985;  // Partial upload refused
+static const uint16_t SW_WRONG_DATA         = 0x6A80;  // Bad fragment order or payload
+static const uint16_t SW_WRONG_P1P2         = 0x6A86;  // Block number out of range
+static const uint16_t SW_INS_NOT_SUPPORTED  = 0x6D00;
+static const uint16_t SW_BUSY               = 0x6F00;  // Still processing the previous fragment
+
+static const uint8_t AUTH_KEY[] = {0x20, 0x09, 0x12, 0x10};
+
+EmulatedPanel emulated_panel(const std::string& name) {
+    EmulatedPanel panel;
+    if (name == "128x296" || name == "296x128") {
+        panel.width = 296;
+        panel.height = 128;
+    } else if (name == "400x300") {
+        panel.width = 400;
+        panel.height = 300;
+    } else {
+        throw std::runtime_error("Unknown emulated panel: " + name +
+                                 " (expected 128x296 or 400x300)");
+    }
+    return panel;
+}
+
+std::vector<uint8_t> build_device_info_response(const EmulatedPanel& panel) {
+    uint8_t color_mode = panel.bits_per_pixel == 1 ? 0x01 : 0x07;
+    int height_raw = panel.height * panel.bits_per_pixel;
+
+    // Rows per 2000-byte block of the (possibly rotated) framebuffer
+    bool rotated = panel.width == 296 && panel.height == 128;
+    int fb_width = rotated ? panel.height : panel.width;
+    int fb_bpr = fb_width * panel.bits_per_pixel / 8;
+    int rows_per_block = std::min(255, 2000 / std::max(1, fb_bpr));
+
+    std::vector<uint8_t> tlv = {
+        0xA0, 0x07,
+        0x00, color_mode, (uint8_t)rows_per_block,
+        (uint8_t)(height_raw >> 8), (uint8_t)(height_raw & 0xFF),
+        (uint8_t)(panel.width >> 8), (uint8_t)(panel.width & 0xFF),
+    };
+    tlv.push_back(0xC0);
+    tlv.push_back((uint8_t)panel.serial_number.size());
+    tlv.insert(tlv.end(), panel.serial_number.begin(), panel.serial_number.end());
+    return tlv;
+}
+
+EmulatorTransport::EmulatorTransport(const EmulatedPanel& panel, const EmulatorTiming& timing)
+    : panel_(panel), timing_(timing), start_(std::chrono::steady_clock::now()) {
+    if (lzo_init() != LZO_E_OK) {
+        throw std::runtime_error("LZO initialization failed");
+    }
+
+    device_info_ = parse_device_info(build_device_info_response(panel_));
+    framebuffer_.assign(device_info_.fb_total_bytes(), 0);
+
+    int offset = 0;
+    for (int size : device_info_.block_sizes()) {
+        block_offsets_.push_back(offset);
+        offset += size;
+    }
+}
+
+EmulatorTransport::~EmulatorTransport() {
+    close();
+}
+
+void EmulatorTransport::open() {
+    connected_ = true;
+    authenticated_ = false;
+    current_block_ = -1;
+    next_fragment_ = 0;
+    block_data_.clear();
+    next_block_ = 0;
+}
+
+// "EMU0009" -> "EMU0010": increments the trailing digits, keeping their width
+static std::string next_serial(const std::string& serial) {
+    std::string next = serial;
+    size_t i = next.size();
+    while (i > 0 && next[i - 1] >= '0' && next[i - 1] <= '9') {
+        if (next[--i] != '9') {
+            next[i]++;
+            return next;
+        }
+        next[i] = '0';
+    }
+    return next.insert(i, "1");  // All nines (or no digits): grow by one digit
+}
+
+bool EmulatorTransport::wait_for_card(std::chrono::milliseconds timeout) {
+    (void)timeout;
+    if (panel_.new_card_per_session && sessions_ > 0) {
+        panel_.serial_number = next_serial(panel_.serial_number);
+        device_info_ = parse_device_info(build_device_info_response(panel_));
+        std::fill(framebuffer_.begin(), framebuffer_.end(), 0);
+        refresh_done_us_ = -1.0;
+    }
+    sessions_++;
+    open();
+    arrived_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool EmulatorTransport::card_present() {
+    if (!connected_) return false;
+    return panel_.dwell_ms <= 0 ||
+           std::chrono::steady_clock::now() - arrived_ < std::chrono::milliseconds(panel_.dwell_ms);
+}
+
+void EmulatorTransport::load_framebuffer(const std::vector<uint8_t>& packed) {
+    if (packed.size() != framebuffer_.size()) {
+        throw std::runtime_error("Framebuffer size does not match the emulated panel");
+    }
+    framebuffer_ = packed;
+}
+
+void EmulatorTransport::close() {
+    connected_ = false;
+}
+
+double EmulatorTransport::now_us() const {
+    if (!timing_.realtime) return stats_.modeled_us;
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start_).count();
+}
+
+std::vector<uint8_t> EmulatorTransport::send_apdu(const Apdu& apdu) {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to a card");
+    }
+
+    uint16_t sw = SW_OK;
+    std::vector<uint8_t> response;
+    last_wtx_ = 0;
+
+    // Image fragments arriving while the card still processes the previous one
+    double held_us = 0.0;
+    bool is_fragment = apdu.cla == 0xF0 && apdu.ins == 0xD3;
+    auto arrival = std::chrono::steady_clock::now();
+    if (is_fragment && arrival < busy_until_) {
+        if (timing_.busy_fails) {
+            sw = SW_BUSY;
+            stats_.busy_errors++;
+        } else {
+            held_us = std::chrono::duration<double, std::micro>(busy_until_ - arrival).count();
+            last_wtx_ = 1;
+            stats_.wtx++;
+        }
+    }
+    if (sw == SW_OK) {
+        response = process(apdu, sw);
+    }
+
+    // Model RF time: C-APDU header [+ Lc + data] [+ Le], R-APDU data + SW
+    size_t tx = 4 + (apdu.has_data && !apdu.data.empty() ? 1 + apdu.data.size() : 0) +
+                (apdu.le >= 0 ? 1 : 0);
+    size_t rx = response.size() + 2;
+    // A C-APDU longer than the card's frame is chained: one exchange per I-block,
+    // each with its PCB + CRC
+    size_t max_inf = (size_t)std::max(1, panel_.fsc - 3);
+    int frames = (int)std::max<size_t>(1, (tx + max_inf - 1) / max_inf);
+    double cost_us = timing_.per_apdu_us * frames +
+                     timing_.per_byte_us * (double)(tx + rx + 3 * frames) + held_us;
+
+    stats_.apdus++;
+    stats_.frames += frames;
+    stats_.bytes_tx += tx;
+    stats_.bytes_rx += rx;
+    stats_.modeled_us += cost_us;
+    if (timing_.realtime && cost_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds((long long)cost_us));
+    }
+    if (is_fragment && sw != SW_BUSY && timing_.fragment_busy_us > 0) {
+        busy_until_ = std::chrono::steady_clock::now() +
+                      std::chrono::microseconds((long long)timing_.fragment_busy_us);
+    }
+
+    if (sw != SW_OK) {
+        // Same contract as the hardware transports: refresh/poll return their payload
+        if (apdu.ins == 0xDE || apdu.ins == 0xD4) return response;
+        throw ApduStatusError(sw);
+    }
+    return response;
+}
+
+std::vector<uint8_t> EmulatorTransport::process(const Apdu& apdu, uint16_t& sw) {
+    // 0020: authenticate
+    if (apdu.cla == 0x00 && apdu.ins == 0x20) {
+        authenticated_ = apdu.data.size() == sizeof(AUTH_KEY) &&
+                         std::equal(apdu.data.begin(), apdu.data.end(), AUTH_KEY);
+        sw = authenticated_ ? SW_OK : SW_SECURITY;
+        return {};
+    }
+
+    // 00D1: device info
+    if (apdu.cla == 0x00 && apdu.ins == 0xD1) {
+        return build_device_info_response(panel_);
+    }
+
+    if (apdu.cla != 0xF0) {
+        sw = SW_INS_NOT_SUPPORTED;
+        return {};
+    }
+
+    switch (apdu.ins) {
+    case 0xD3:  // Image data fragment
+        sw = authenticated_ ? receive_fragment(apdu) : SW_SECURITY;
+        return {};
+
+    case 0xD4:  // Start refresh
+        if (!authenticated_) {
+            sw = SW_SECURITY;
+            return {};
+        }
+        stats_.refreshes++;
+        next_block_ = 0;
+        refresh_done_us_ = now_us() + timing_.refresh_ms * 1000.0;
+        return {};
+
+    case 0xDE: {  // Poll refresh state: 00 = done
+        if (!timing_.realtime && refresh_done_us_ > stats_.modeled_us) {
+            // The host sleeps between polls; account the remaining refresh time
+            stats_.modeled_us = refresh_done_us_;
+        }
+        bool busy = refresh_done_us_ >= 0 && now_us() < refresh_done_us_;
+        return {(uint8_t)(busy ? 0x01 : 0x00)};
+    }
+
+    default:
+        sw = SW_INS_NOT_SUPPORTED;
+        return {};
+    }
+}
+
+uint16_t EmulatorTransport::receive_fragment(const Apdu& apdu) {
+    if (apdu.data.size() < 2) return SW_WRONG_DATA;
+
+    int block_no = apdu.data[0];
+    int frag_no = apdu.data[1];
+    bool is_final = apdu.p2 == 0x01;
+
+    if (block_no >= (int)block_offsets_.size()) return SW_WRONG_P1P2;
+
+    if (frag_no == 0) {
+        if (!panel_.partial_updates && block_no != next_block_) {
+            return SW_CONDITIONS;
+        }
+        current_block_ = block_no;
+        block_data_.clear();
+    } else if (block_no != current_block_ || frag_no != next_fragment_) {
+        current_block_ = -1;
+        return SW_WRONG_DATA;
+    }
+    next_fragment_ = frag_no + 1;
+    block_data_.insert(block_data_.end(), apdu.data.begin() + 2, apdu.data.end());
+
+    if (!is_final) return SW_OK;
+
+    // Last fragment: decompress the block into the framebuffer
+    current_block_ = -1;
+    int expected = device_info_.block_sizes()[block_no];
+    std::vector<uint8_t> out(expected);
+    lzo_uint out_len = out.size();
+    int ret = lzo1x_decompress_safe(block_data_.data(), (lzo_uint)block_data_.size(),
+                                    out.data(), &out_len, nullptr);
+    if (ret != LZO_E_OK || (int)out_len != expected) return SW_WRONG_DATA;
+
+    std::copy(out.begin(), out.end(), framebuffer_.begin() + block_offsets_[block_no]);
+    stats_.blocks_received++;
+    next_block_ = block_no + 1;
+    return SW_OK;
+}
+
+// Factory function for the emulator backend
+#ifdef NFC_BACKEND_EMULATOR
+std::unique_ptr<NfcTransport> create_nfc_transport() {
+    return std::make_unique<EmulatorTransport>();
+}
+
+std::unique_ptr<NfcTransport> create_nfc_transport(const std::string& reader_id) {
+    (void)reader_id;
+    return std::make_unique<EmulatorTransport>();
+}
+
+std::vector<std::string> list_nfc_readers() {
+    return {"emulator"};
+}
+#endif
@@ -3,19 +3,27 @@
 #include <nfc/nfc.h>
 #include <nfc/nfc-types.h>
 
+#include <chrono>
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
-#include <iomanip>
-#include <sstream>
+#include <thread>
 
-LibnfcTransport::LibnfcTransport() {}
+LibnfcTransport::LibnfcTransport(std::string reader_id) : reader_id_(std::move(reader_id)) {}
 
 LibnfcTransport::~LibnfcTransport() {
     close();
 }
 
 void LibnfcTransport::open() {
+    open_reader();
+    std::cout << "Waiting for NFC card..." << std::endl;
+    if (!wait_for_card(std::chrono::seconds(25))) {
+        throw std::runtime_error("No NFC card detected");
+    }
+}
+
+void LibnfcTransport::open_reader() {
     nfc_context* context = nullptr;
     nfc_init(&context);
     if (!context) {
@@ -23,7 +31,7 @@ void LibnfcTransport::open() {
     }
     nfc_context_ = context;
 
-    nfc_device* device = nfc_open(context, nullptr);
+    nfc_device* device = nfc_open(context, reader_id_.empty() ? nullptr : reader_id_.c_str());
     if (!device) {
         throw std::runtime_error(
             "Failed to open NFC device. libnfc-supported reader required "
@@ -34,19 +42,72 @@ void LibnfcTransport::open() {
     if (nfc_initiator_init(device) < 0) {
         throw std::runtime_error("Failed to initialize NFC initiator mode");
     }
+    // Return from target selection when no card answers instead of blocking
+    nfc_device_set_property_bool(device, NP_INFINITE_SELECT, false);
+    poller_.reset();
+}
+
+bool LibnfcTransport::wait_for_card(std::chrono::milliseconds timeout) {
+    if (!nfc_device_) {
+        throw std::runtime_error("Reader not open");
+    }
+    nfc_device* device = static_cast<nfc_device*>(nfc_device_);
 
     // Poll for ISO14443-4A target
     nfc_modulation nm;
     nm.nmt = NMT_ISO14443A;
     nm.nbr = NBR_106;
 
+    // Release a card left selected by a previous session
+    nfc_initiator_deselect_target(device);
+
+    // libnfc sets up the RF itself; each poll is one selection attempt, which
+    // also activates the card, so activation time is counted in the poll
     nfc_target target;
-    std::cout << "Waiting for NFC card..." << std::endl;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    int res = 0;
+    poller_.begin();
+    do {
+        poller_.poll();
+        res = nfc_initiator_select_passive_target(device, nm, nullptr, 0, &target);
+        if (res < 0) {
+            throw std::runtime_error(std::string("NFC reader error: ") + nfc_strerror(device));
+        }
+        if (res > 0) break;
+    } while (poller_.wait_next(deadline));
+    if (res == 0) return false;
+    poller_.answered();
+    poller_.activated();
+
+    // libnfc strips TL from the ATS; the reader chains frames itself, but a
+    // C-APDU that fits the card's frame avoids the extra exchanges
+    const auto& nai = target.nti.nai;
+    std::vector<uint8_t> ats = {(uint8_t)(nai.szAtsLen + 1)};
+    ats.insert(ats.end(), nai.abtAts, nai.abtAts + nai.szAtsLen);
+    ats_ = parse_ats(ats);
+    return true;
+}
 
-    int res = nfc_initiator_select_passive_target(device, nm, nullptr, 0, &target);
-    if (res <= 0) {
-        throw std::runtime_error("No NFC card detected");
+void LibnfcTransport::set_polling(const PollSettings& settings) {
+    poller_.configure(settings);
+}
+
+bool LibnfcTransport::card_present() {
+    if (!nfc_device_) return false;
+    return nfc_initiator_target_is_present(static_cast<nfc_device*>(nfc_device_), nullptr) == NFC_SUCCESS;
+}
+
+std::vector<std::string> LibnfcTransport::list_readers() {
+    nfc_context* context = nullptr;
+    nfc_init(&context);
+    if (!context) {
+        throw std::runtime_error("Failed to initialize libnfc");
     }
+    nfc_connstring found[16];
+    size_t count = nfc_list_devices(context, found, 16);
+    std::vector<std::string> ids(found, found + count);
+    nfc_exit(context);
+    return ids;
 }
 
 void LibnfcTransport::close() {
@@ -103,10 +164,7 @@ std::vector<uint8_t> LibnfcTransport::send_apdu(const Apdu& apdu) {
         if (apdu.ins == 0xDE || apdu.ins == 0xD4) {
             return std::vector<uint8_t>(rx, rx + rx_len - 2);
         }
-        std::ostringstream oss;
-        oss << "APDU error: SW=" << std::hex << std::setw(2) << std::setfill('0')
-            << (int)sw1 << std::setw(2) << (int)sw2;
-        throw std::runtime_error(oss.str());
+        throw ApduStatusError((uint16_t)(sw1 << 8 | sw2));
     }
 
     return std::vector<uint8_t>(rx, rx + rx_len - 2);
@@ -117,4 +175,12 @@ std::vector<uint8_t> LibnfcTransport::send_apdu(const Apdu& apdu) {
 std::unique_ptr<NfcTransport> create_nfc_transport() {
     return std::make_unique<LibnfcTransport>();
 }
+
+std::unique_ptr<NfcTransport> create_nfc_transport(const std::string& reader_id) {
+    return std::make_unique<LibnfcTransport>(reader_id);
+}
+
+std::vector<std::string> list_nfc_readers() {
+    return LibnfcTransport::list_readers();
+}
 #endif
@@ -1,7 +1,10 @@
 #include "transport_rcs380.hpp"
+#include "metrics.hpp"
 
 #include <libusb-1.0/libusb.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 #include <thread>
@@ -26,7 +29,14 @@ static const std::vector<uint8_t> IN_SET_PROTOCOL_DEFAULTS = {
     0x11, 0x00, 0x12, 0x00, 0x13, 0x06
 };
 
-Rcs380Transport::Rcs380Transport() {}
+// Field-off time that resets a card left active by a previous session
+static const std::chrono::milliseconds FIELD_RESET(20);
+
+// SENS_RES follows SENS_REQ within 100 us; a short timeout keeps idle polls quick
+static const int FAST_SENS_TIMEOUT_MS = 5;
+
+Rcs380Transport::Rcs380Transport(bool async_usb, std::string reader_id)
+    : reader_id_(std::move(reader_id)), async_usb_(async_usb) {}
 
 Rcs380Transport::~Rcs380Transport() {
     close();
@@ -34,17 +44,50 @@ Rcs380Transport::~Rcs380Transport() {
 
 // ==================== USB Transport ====================
 
+// Stable name of a USB device: bus and port path, e.g. "usb:1-2.3". It does not
+// change when the reader is replugged into the same port.
+static std::string usb_device_id(libusb_device* dev) {
+    uint8_t ports[8];
+    int depth = libusb_get_port_numbers(dev, ports, sizeof(ports));
+    std::string id = "usb:" + std::to_string(libusb_get_bus_number(dev));
+    for (int i = 0; i < depth; i++) {
+        id += (i == 0 ? "-" : ".") + std::to_string(ports[i]);
+    }
+    return id;
+}
+
 void Rcs380Transport::usb_open() {
     libusb_context* ctx = nullptr;
-    if (libusb_init(&ctx) < 0) {
+    if (async_usb_) {
+        // Every reader shares one context, whose event thread runs the transfers
+        loop_ = UsbEventLoop::shared();
+        ctx = static_cast<libusb_context*>(loop_->context());
+    } else if (libusb_init(&ctx) < 0) {
         throw std::runtime_error("Failed to initialize libusb");
     }
     usb_ctx_ = ctx;
 
-    libusb_device_handle* handle = libusb_open_device_with_vid_pid(
-        ctx, RC_S380_VENDOR_ID, RC_S380_PRODUCT_ID);
-    if (!handle) {
-        throw std::runtime_error("RC-S380 not found (is it connected?)");
+    libusb_device_handle* handle = nullptr;
+    if (reader_id_.empty()) {
+        handle = libusb_open_device_with_vid_pid(ctx, RC_S380_VENDOR_ID, RC_S380_PRODUCT_ID);
+        if (!handle) {
+            throw std::runtime_error("RC-S380 not found (is it connected?)");
+        }
+    } else {
+        libusb_device** list = nullptr;
+        ssize_t count = libusb_get_device_list(ctx, &list);
+        int ret = LIBUSB_ERROR_NOT_FOUND;
+        for (ssize_t i = 0; i < count; i++) {
+            if (usb_device_id(list[i]) == reader_id_) {
+                ret = libusb_open(list[i], &handle);
+                break;
+            }
+        }
+        if (list) libusb_free_device_list(list, 1);
+        if (ret < 0) {
+            throw std::runtime_error("Cannot open reader " + reader_id_ + ": " +
+                                     libusb_error_name(ret));
+        }
     }
     usb_handle_ = handle;
 
@@ -76,11 +119,11 @@ void Rcs380Transport::usb_open() {
     }
 }
 
-void Rcs380Transport::usb_write(const std::vector<uint8_t>& data) {
+void Rcs380Transport::usb_write(const uint8_t* data, size_t size) {
     auto handle = static_cast<libusb_device_handle*>(usb_handle_);
     int transferred;
     int ret = libusb_bulk_transfer(handle, ep_out_,
-        const_cast<uint8_t*>(data.data()), (int)data.size(),
+        const_cast<uint8_t*>(data), (int)size,
         &transferred, 5000);
     if (ret < 0) {
         throw std::runtime_error(std::string("USB write failed: ") +
@@ -88,124 +131,183 @@ void Rcs380Transport::usb_write(const std::vector<uint8_t>& data) {
     }
 }
 
-std::vector<uint8_t> Rcs380Transport::usb_read(int timeout_ms) {
+Rcs380Transport::UsbStatus Rcs380Transport::usb_read(uint8_t* buf, size_t size,
+                                                     size_t& transferred, int timeout_ms) {
     auto handle = static_cast<libusb_device_handle*>(usb_handle_);
-    uint8_t buf[512];
-    int transferred;
-    int ret = libusb_bulk_transfer(handle, ep_in_, buf, sizeof(buf),
-                                   &transferred, timeout_ms);
+    int n = 0;
+    int ret = libusb_bulk_transfer(handle, ep_in_, buf, (int)size, &n, timeout_ms);
+    transferred = n > 0 ? (size_t)n : 0;
     if (ret == LIBUSB_ERROR_TIMEOUT) {
-        throw std::runtime_error("USB read timeout");
+        return UsbStatus::Timeout;
     }
     if (ret < 0) {
         throw std::runtime_error(std::string("USB read failed: ") +
                                  libusb_error_name(ret));
     }
-    return std::vector<uint8_t>(buf, buf + transferred);
+    return UsbStatus::Ok;
 }
 
 void Rcs380Transport::close() {
+    pipe_.reset();
     if (usb_handle_) {
         auto handle = static_cast<libusb_device_handle*>(usb_handle_);
         libusb_release_interface(handle, 0);
         libusb_close(handle);
         usb_handle_ = nullptr;
     }
-    if (usb_ctx_) {
+    if (loop_) {
+        loop_.reset();
+    } else if (usb_ctx_) {
         libusb_exit(static_cast<libusb_context*>(usb_ctx_));
-        usb_ctx_ = nullptr;
     }
+    usb_ctx_ = nullptr;
 }
 
 // ==================== NFC Port-100 Framing ====================
 
-std::vector<uint8_t> Rcs380Transport::build_frame(const std::vector<uint8_t>& data) {
-    std::vector<uint8_t> frame = {0x00, 0x00, 0xFF, 0xFF, 0xFF};
-    uint16_t len = (uint16_t)data.size();
-    frame.push_back(len & 0xFF);
-    frame.push_back((len >> 8) & 0xFF);
-    uint8_t len_sum = (uint8_t)((256 - ((frame[5] + frame[6]) & 0xFF)) & 0xFF);
-    frame.push_back(len_sum);
-    frame.insert(frame.end(), data.begin(), data.end());
+void Rcs380Transport::build_frame(uint8_t cmd_code, const uint8_t* data, size_t size) {
+    // 00 00 FF FF FF LEN(2) LCS | D6 CMD DATA... | DCS 00
+    uint16_t len = (uint16_t)(size + 2);
+    tx_.clear();
+    tx_.insert(tx_.end(), {0x00, 0x00, 0xFF, 0xFF, 0xFF,
+                           (uint8_t)(len & 0xFF), (uint8_t)((len >> 8) & 0xFF)});
+    tx_.push_back((uint8_t)((256 - ((tx_[5] + tx_[6]) & 0xFF)) & 0xFF));
+    tx_.push_back(0xD6);
+    tx_.push_back(cmd_code);
+    tx_.insert(tx_.end(), data, data + size);
     uint8_t data_sum = 0;
-    for (size_t i = 8; i < frame.size(); i++) data_sum += frame[i];
-    frame.push_back((uint8_t)((256 - data_sum) & 0xFF));
-    frame.push_back(0x00);
-    return frame;
+    for (size_t i = 8; i < tx_.size(); i++) data_sum += tx_[i];
+    tx_.push_back((uint8_t)((256 - data_sum) & 0xFF));
+    tx_.push_back(0x00);
 }
 
-std::vector<uint8_t> Rcs380Transport::parse_frame(const std::vector<uint8_t>& frame) {
-    if (frame.size() >= 6 &&
-        frame[0] == 0x00 && frame[1] == 0x00 && frame[2] == 0xFF) {
-        if (frame[3] == 0x00 && frame[4] == 0xFF && frame[5] == 0x00) {
-            return {};
+bool Rcs380Transport::parse_frame(uint8_t cmd_code) {
+    // Consume complete frames from rx_ring_; true once the response to cmd_code
+    // has been copied (without the D7 CMD+1 header) into rsp_
+    ByteRing& ring = rx_ring_;
+    while (ring.size() >= 6) {
+        // Resynchronize on the 00 00 FF start sequence
+        size_t start = 0;
+        while (start + 3 <= ring.size() &&
+               !(ring[start] == 0x00 && ring[start + 1] == 0x00 && ring[start + 2] == 0xFF)) {
+            start++;
         }
-        if (frame[3] == 0xFF && frame[4] == 0xFF && frame.size() >= 8) {
-            uint16_t len = frame[5] | (frame[6] << 8);
-            if (frame.size() >= (size_t)(8 + len)) {
-                return std::vector<uint8_t>(frame.begin() + 8, frame.begin() + 8 + len);
-            }
+        if (start + 3 > ring.size()) {
+            // Keep a possible partial start sequence
+            ring.consume(ring.size() - 2);
+            return false;
+        }
+        ring.consume(start);
+        if (ring.size() < 6) return false;
+
+        if (ring[3] == 0x00 && ring[4] == 0xFF && ring[5] == 0x00) {
+            ring.consume(sizeof(ACK_FRAME));
+            continue;
+        }
+
+        if (ring[3] != 0xFF || ring[4] != 0xFF) {
+            ring.consume(1);  // Not a frame we understand
+            continue;
         }
+        if (ring.size() < 8) return false;
+
+        size_t len = ring[5] | (ring[6] << 8);
+        if (((ring[5] + ring[6] + ring[7]) & 0xFF) != 0 || 10 + len > ring.capacity()) {
+            ring.consume(1);  // Corrupt length
+            continue;
+        }
+        if (ring.size() < 10 + len) return false;
+
+        bool match = len >= 2 && ring[8] == 0xD7 && ring[9] == (uint8_t)(cmd_code + 1);
+        if (match) {
+            rsp_.resize(len - 2);
+            ring.copy_out(10, len - 2, rsp_.data());
+        }
+        ring.consume(10 + len);
+        if (match) return true;
     }
-    return {};
+    return false;
 }
 
-std::vector<uint8_t> Rcs380Transport::send_command(uint8_t cmd_code,
-                                                    const std::vector<uint8_t>& cmd_data) {
-    std::vector<uint8_t> cmd = {0xD6, cmd_code};
-    cmd.insert(cmd.end(), cmd_data.begin(), cmd_data.end());
-    usb_write(build_frame(cmd));
-
-    std::vector<uint8_t> buffer;
+const std::vector<uint8_t>& Rcs380Transport::send_command(uint8_t cmd_code,
+                                                          const uint8_t* data, size_t size) {
+    static Histogram& command_time = Metrics::global().histogram(
+        "send_epaper_port100_command_seconds", "Round trip of one RC-S380 Port-100 command");
+    static Counter& frame_bytes = Metrics::global().counter(
+        "send_epaper_port100_bytes_total", "Port-100 frame bytes written to the reader");
+    ScopedTimer timer(command_time);
+    build_frame(cmd_code, data, size);
+    frame_bytes.add(tx_.size());
+    if (pipe_) return send_command_async(cmd_code);
+    usb_write(tx_.data(), tx_.size());
+
+    rx_ring_.clear();
     auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
 
     while (std::chrono::steady_clock::now() < deadline) {
-        try {
-            auto raw = usb_read(500);
-            buffer.insert(buffer.end(), raw.begin(), raw.end());
-        } catch (const std::exception& e) {
-            // Ignore timeouts, just keep waiting until deadline
-            if (std::string(e.what()).find("timeout") == std::string::npos) throw;
+        size_t transferred = 0;
+        // Timeouts are expected: keep waiting until the deadline
+        if (usb_read(rx_chunk_, sizeof(rx_chunk_), transferred, 500) == UsbStatus::Timeout) {
+            continue;
         }
+        if (!rx_ring_.push(rx_chunk_, transferred)) {
+            rx_ring_.clear();  // Only garbage can fill the ring; start over
+            rx_ring_.push(rx_chunk_, transferred);
+        }
+        if (parse_frame(cmd_code)) return rsp_;
+    }
 
-        // Process buffer for frames
-        while (buffer.size() >= 6) {
-            auto it = std::search(buffer.begin(), buffer.end(), ACK_FRAME, ACK_FRAME + 3);
-            if (it == buffer.end()) {
-                if (buffer.size() > 1024) buffer.clear(); // Safety
-                break;
-            }
-            if (it != buffer.begin()) {
-                buffer.erase(buffer.begin(), it);
-            }
+    throw std::runtime_error("Timeout waiting for RC-S380 command response");
+}
 
-            if (buffer.size() < 6) break;
+const std::vector<uint8_t>& Rcs380Transport::send_command_async(uint8_t cmd_code) {
+    std::future<void> done;
+    {
+        std::lock_guard<std::mutex> lock(rx_mutex_);
+        if (!usb_error_.empty()) throw std::runtime_error(usb_error_);
+        rx_ring_.clear();
+        pending_.emplace();
+        pending_cmd_ = cmd_code;
+        done = pending_->get_future();
+    }
 
-            if (buffer[3] == 0x00 && buffer[4] == 0xFF && buffer[5] == 0x00) {
-                buffer.erase(buffer.begin(), buffer.begin() + 6);
-                continue;
-            }
+    // The IN transfer is already posted: the response is parsed as it arrives
+    try {
+        pipe_->write(tx_.data(), tx_.size());
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(rx_mutex_);
+        pending_.reset();
+        throw;
+    }
 
-            if (buffer.size() >= 10 && buffer[3] == 0xFF && buffer[4] == 0xFF) {
-                uint16_t len = buffer[5] | (buffer[6] << 8);
-                if (buffer.size() >= (size_t)(10 + len)) {
-                    auto data_frame = std::vector<uint8_t>(buffer.begin(), buffer.begin() + 10 + len);
-                    buffer.erase(buffer.begin(), buffer.begin() + 10 + len);
-                    
-                    auto rsp = parse_frame(data_frame);
-                    if (rsp.size() >= 2 && rsp[0] == 0xD7 && rsp[1] == cmd_code + 1) {
-                        return std::vector<uint8_t>(rsp.begin() + 2, rsp.end());
-                    }
-                } else {
-                    break;
-                }
-            } else if (buffer.size() >= 6) {
-                buffer.erase(buffer.begin()); // Skip invalid byte
-            }
-        }
+    if (done.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+        std::lock_guard<std::mutex> lock(rx_mutex_);
+        pending_.reset();
+        throw std::runtime_error("Timeout waiting for RC-S380 command response");
     }
+    done.get();  // Rethrows a USB error reported by the event thread
+    return rsp_;
+}
 
-    throw std::runtime_error("Timeout waiting for RC-S380 command response");
+void Rcs380Transport::on_usb_data(const uint8_t* data, size_t size) {
+    std::lock_guard<std::mutex> lock(rx_mutex_);
+    if (!rx_ring_.push(data, size)) {
+        rx_ring_.clear();
+        rx_ring_.push(data, size);
+    }
+    if (pending_ && parse_frame(pending_cmd_)) {
+        pending_->set_value();
+        pending_.reset();
+    }
+}
+
+void Rcs380Transport::on_usb_error(const std::string& message) {
+    std::lock_guard<std::mutex> lock(rx_mutex_);
+    usb_error_ = message;
+    if (pending_) {
+        pending_->set_exception(std::make_exception_ptr(std::runtime_error(message)));
+        pending_.reset();
+    }
 }
 
 void Rcs380Transport::set_command_type(uint8_t type) {
@@ -237,13 +339,14 @@ void Rcs380Transport::in_set_protocol(const std::vector<uint8_t>& data) {
     if (!result.empty() && result[0] != 0) throw std::runtime_error("in_set_protocol failed");
 }
 
-std::vector<uint8_t> Rcs380Transport::in_comm_rf(const std::vector<uint8_t>& data, int timeout_ms) {
+void Rcs380Transport::in_comm_rf(const uint8_t* data, size_t size, int timeout_ms,
+                                 std::vector<uint8_t>& out) {
     uint16_t timeout = std::min((timeout_ms + 1) * 10, 0xFFFF);
-    std::vector<uint8_t> cmd_data;
-    cmd_data.push_back(timeout & 0xFF);
-    cmd_data.push_back((timeout >> 8) & 0xFF);
-    cmd_data.insert(cmd_data.end(), data.begin(), data.end());
-    auto result = send_command(0x04, cmd_data);
+    comm_.clear();
+    comm_.push_back(timeout & 0xFF);
+    comm_.push_back((timeout >> 8) & 0xFF);
+    comm_.insert(comm_.end(), data, data + size);
+    const auto& result = send_command(0x04, comm_.data(), comm_.size());
     if (result.size() >= 4 && (result[0] != 0 || result[1] != 0 ||
                                 result[2] != 0 || result[3] != 0)) {
         std::ostringstream oss;
@@ -252,67 +355,88 @@ std::vector<uint8_t> Rcs380Transport::in_comm_rf(const std::vector<uint8_t>& dat
             << std::setw(2) << std::setfill('0') << (int)result[1] << " "
             << std::setw(2) << std::setfill('0') << (int)result[2] << " "
             << std::setw(2) << std::setfill('0') << (int)result[3];
-        throw std::runtime_error(oss.str());
+        throw RfError(oss.str());
     }
     if (result.size() > 5) {
-        return std::vector<uint8_t>(result.begin() + 5, result.end());
+        out.assign(result.begin() + 5, result.end());
+    } else {
+        out.clear();
     }
-    return {};
+}
+
+std::vector<uint8_t> Rcs380Transport::in_comm_rf(const std::vector<uint8_t>& data, int timeout_ms) {
+    std::vector<uint8_t> out;
+    in_comm_rf(data.data(), data.size(), timeout_ms, out);
+    return out;
 }
 
 // ==================== ISO14443A Target Activation ====================
 
-bool Rcs380Transport::sense_and_activate_target() {
+void Rcs380Transport::configure_type_a() {
     in_set_rf({0x02, 0x03, 0x0F, 0x03});
     in_set_protocol(IN_SET_PROTOCOL_DEFAULTS);
-    in_set_protocol({
-        0x00, 0x06, 0x01, 0x00, 0x02, 0x00, 0x05, 0x01, 0x07, 0x07,
-    });
+    sens_ready_ = false;
+}
 
-    std::vector<uint8_t> sens_res;
-    try { sens_res = in_comm_rf({0x26}, 30); } catch (...) { return false; }
-    if (sens_res.size() != 2) return false;
+bool Rcs380Transport::sense_request(int timeout_ms) {
+    // Short frame (7 bits), no CRC; anticollision changes these, so they are
+    // only sent again after a card answered
+    if (!sens_ready_) {
+        in_set_protocol({
+            0x00, 0x06, 0x01, 0x00, 0x02, 0x00, 0x05, 0x01, 0x07, 0x07,
+        });
+        sens_ready_ = true;
+    }
 
+    static const uint8_t SENS_REQ = 0x26;
+    try { in_comm_rf(&SENS_REQ, 1, timeout_ms, rf_rsp_); } catch (const RfError&) { return false; }
+    return rf_rsp_.size() == 2;
+}
+
+bool Rcs380Transport::activate_target() {
+    sens_ready_ = false;
     in_set_protocol({0x07, 0x08, 0x04, 0x01});
 
     uint8_t sak = 0;
     for (uint8_t sel_cmd : {0x93, 0x95, 0x97}) {
         in_set_protocol({0x01, 0x00, 0x02, 0x00});
         std::vector<uint8_t> sdd_res;
-        try { sdd_res = in_comm_rf({sel_cmd, 0x20}, 30); } catch (...) { return false; }
+        try { sdd_res = in_comm_rf({sel_cmd, 0x20}, 30); } catch (const RfError&) { return false; }
         if (sdd_res.size() < 5) return false;
 
         in_set_protocol({0x01, 0x01, 0x02, 0x01});
         std::vector<uint8_t> sel_req = {sel_cmd, 0x70};
         sel_req.insert(sel_req.end(), sdd_res.begin(), sdd_res.end());
         std::vector<uint8_t> sel_res;
-        try { sel_res = in_comm_rf(sel_req, 30); } catch (...) { return false; }
+        try { sel_res = in_comm_rf(sel_req, 30); } catch (const RfError&) { return false; }
         if (sel_res.empty()) return false;
         sak = sel_res[0];
         if (!(sak & 0x04)) break;
     }
 
     if (!(sak & 0x20)) {
-        throw std::runtime_error("Card does not support ISO14443-4");
+        throw RfError("Card does not support ISO14443-4");
     }
 
     // Send RATS (Request for Answer To Select)
     // PARAM byte: FSD=256 (0x80), CID=0
     auto ats = in_comm_rf({0xE0, 0x80}, 30);
     if (ats.empty()) {
-        throw std::runtime_error("RATS failed");
+        throw RfError("RATS failed");
     }
 
     std::cout << "RATS Response: ";
     for (uint8_t b : ats) std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)b << " ";
     std::cout << std::dec << std::endl;
 
-    if (ats.size() >= 2) {
-        uint8_t fsci = ats[1] & 0x0F;
-        int fsc[] = {16, 24, 32, 40, 48, 64, 96, 128, 256};
-        if (fsci <= 8) {
-            std::cout << "Card FSC: " << fsc[fsci] << " bytes (FSCI=" << (int)fsci << ")" << std::endl;
-        }
+    ats_ = parse_ats(ats);
+    block_nr_ = 0;  // Each activation starts a new ISO-DEP session
+    std::cout << "Card FSC: " << ats_.fsc << " bytes, FWT: " << (long)ats_.fwt_us() << " us"
+              << std::endl;
+
+    // The card may ignore frames sent before its start-up guard time has passed
+    if (ats_.sfgi > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds((long long)ats_.sfgt_us()));
     }
 
     return true;
@@ -338,23 +462,26 @@ std::vector<uint8_t> Rcs380Transport::send_apdu(const Apdu& apdu) {
 }
 
 std::vector<uint8_t> Rcs380Transport::_send_apdu_impl(const std::vector<uint8_t>& apdu_bytes) {
-    const int MIU = 253;
-    std::vector<uint8_t> response;
+    const int MIU = ats_.max_inf();
+    std::vector<uint8_t>& response = rf_rsp_;
+    last_wtx_ = 0;
 
     for (size_t offset = 0; offset < apdu_bytes.size(); offset += MIU) {
         bool more = (apdu_bytes.size() - offset) > (size_t)MIU;
         size_t chunk_end = std::min(offset + (size_t)MIU, apdu_bytes.size());
 
         uint8_t pcb = (more ? 0x12 : 0x02) | (block_nr_ & 0x01);
-        std::vector<uint8_t> iblock;
-        iblock.push_back(pcb);
-        iblock.insert(iblock.end(), apdu_bytes.begin() + offset, apdu_bytes.begin() + chunk_end);
+        iblock_.clear();
+        iblock_.push_back(pcb);
+        iblock_.insert(iblock_.end(), apdu_bytes.begin() + offset, apdu_bytes.begin() + chunk_end);
 
-        response = in_comm_rf(iblock, 5000);
+        in_comm_rf(iblock_.data(), iblock_.size(), 5000, response);
 
         // Handle WTX S-blocks
         while (!response.empty() && (response[0] & 0xFE) == 0xF2) {
-            response = in_comm_rf({0xF2, response[1]}, (response[1] & 0x3F) * 1000);
+            uint8_t wtx[] = {0xF2, response[1]};
+            in_comm_rf(wtx, sizeof(wtx), (response[1] & 0x3F) * 1000, response);
+            last_wtx_++;
         }
 
         if (more) {
@@ -379,8 +506,8 @@ std::vector<uint8_t> Rcs380Transport::_send_apdu_impl(const std::vector<uint8_t>
 
     while (!response.empty() && (response[0] & 0x10)) {
         // Card is chaining; send R(ACK)
-        std::vector<uint8_t> ack = {(uint8_t)(0xA2 | (block_nr_ & 0x01))};
-        response = in_comm_rf(ack, 5000);
+        uint8_t ack = (uint8_t)(0xA2 | (block_nr_ & 0x01));
+        in_comm_rf(&ack, 1, 5000, response);
         if (!response.empty()) {
             full_response.insert(full_response.end(), response.begin() + 1, response.end());
             block_nr_ ^= 1;
@@ -400,10 +527,7 @@ std::vector<uint8_t> Rcs380Transport::_send_apdu_impl(const std::vector<uint8_t>
         if (apdu_bytes.size() >= 2 && (apdu_bytes[1] == 0xDE || apdu_bytes[1] == 0xD4)) {
             return std::vector<uint8_t>(full_response.begin(), full_response.end() - 2);
         }
-        std::ostringstream oss;
-        oss << "APDU error: SW=" << std::hex << std::setw(2) << std::setfill('0')
-            << (int)sw1 << std::setw(2) << (int)sw2;
-        throw std::runtime_error(oss.str());
+        throw ApduStatusError((uint16_t)(sw1 << 8 | sw2));
     }
 
     return std::vector<uint8_t>(full_response.begin(), full_response.end() - 2);
@@ -412,36 +536,147 @@ std::vector<uint8_t> Rcs380Transport::_send_apdu_impl(const std::vector<uint8_t>
 // ==================== Public Interface ====================
 
 void Rcs380Transport::open() {
+    open_reader();
+    std::cout << "Waiting for NFC card..." << std::endl;
+    if (!wait_for_card(std::chrono::seconds(25))) {
+        throw std::runtime_error("No NFC card detected");
+    }
+}
+
+void Rcs380Transport::open_reader() {
     usb_open();
 
-    std::vector<uint8_t> ack(ACK_FRAME, ACK_FRAME + sizeof(ACK_FRAME));
-    usb_write(ack);
-    try { while (true) { usb_read(100); } } catch (...) {}
+    usb_write(ACK_FRAME, sizeof(ACK_FRAME));
+    // Drain whatever the reader still had queued
+    size_t transferred = 0;
+    while (usb_read(rx_chunk_, sizeof(rx_chunk_), transferred, 100) == UsbStatus::Ok) {}
+
+    if (async_usb_) {
+        usb_error_.clear();
+        pipe_ = std::make_unique<UsbAsyncPipe>(
+            loop_, usb_handle_, ep_out_, ep_in_,
+            [this](const uint8_t* data, size_t size) { on_usb_data(data, size); },
+            [this](const std::string& message) { on_usb_error(message); });
+    }
 
     set_command_type(1);
     get_firmware_version();
     switch_rf(false);
+    rf_configured_ = false;
+    rf_ready_ = false;
+    poller_.reset();
+}
 
-    std::cout << "Waiting for NFC card..." << std::endl;
-
-    bool found = false;
-    for (int i = 0; i < 100; i++) {
-        switch_rf(true);
-        try {
-            if (sense_and_activate_target()) { found = true; break; }
-        } catch (...) {}
+bool Rcs380Transport::wait_for_card(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    poller_.begin();
+    if (!poller_.settings().fast) {
+        // Full setup every poll: field on, RF and protocol settings, SENS_REQ, field off
         switch_rf(false);
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::this_thread::sleep_for(FIELD_RESET);
+        do {
+            poller_.poll();
+            switch_rf(true);
+            try {
+                configure_type_a();
+                if (sense_request(30)) {
+                    poller_.answered();
+                    if (activate_target()) {
+                        poller_.activated();
+                        return true;
+                    }
+                }
+            } catch (const RfError&) {}
+            switch_rf(false);
+            rf_ready_ = false;
+        } while (poller_.wait_next(deadline));
+        return false;
     }
 
-    if (!found) {
-        throw std::runtime_error("No NFC card detected");
+    // Fast: the field stays up between polls, so an idle poll is a single SENS_REQ.
+    // It is only dropped to reset a card activated earlier (an active card ignores
+    // SENS_REQ) or after a failed activation. Only RF errors count as "no card";
+    // reader and USB errors (reader unplugged) propagate.
+    if (!rf_ready_) reset_field();
+    do {
+        poller_.poll();
+        if (sense_request(FAST_SENS_TIMEOUT_MS)) {
+            poller_.answered();
+            bool ok = false;
+            try { ok = activate_target(); } catch (const RfError&) {}
+            // Whatever state the card is in now, the next wait starts from a fresh field
+            rf_ready_ = false;
+            if (ok) {
+                poller_.activated();
+                return true;
+            }
+            reset_field();
+        }
+    } while (poller_.wait_next(deadline));
+    return false;
+}
+
+void Rcs380Transport::reset_field() {
+    switch_rf(false);
+    std::this_thread::sleep_for(FIELD_RESET);
+    // The RF and protocol settings survive switching the field
+    if (!rf_configured_) {
+        configure_type_a();
+        rf_configured_ = true;
+    }
+    switch_rf(true);
+    rf_ready_ = true;
+}
+
+void Rcs380Transport::set_polling(const PollSettings& settings) {
+    poller_.configure(settings);
+}
+
+bool Rcs380Transport::card_present() {
+    if (!usb_handle_) return false;
+    // ISO-DEP presence check: the card answers R(NAK) with R(ACK) for its current
+    // block number, which leaves the block numbering unchanged
+    uint8_t nak = (uint8_t)(0xB2 | (block_nr_ & 0x01));
+    int timeout_ms = std::max(30, (int)(ats_.fwt_us() / 1000) + 1);
+    try {
+        in_comm_rf(&nak, 1, timeout_ms, rf_rsp_);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !rf_rsp_.empty() && (rf_rsp_[0] & 0xF6) == 0xA2;
+}
+
+std::vector<std::string> Rcs380Transport::list_readers() {
+    auto loop = UsbEventLoop::shared();
+    auto ctx = static_cast<libusb_context*>(loop->context());
+    std::vector<std::string> ids;
+    libusb_device** list = nullptr;
+    ssize_t count = libusb_get_device_list(ctx, &list);
+    for (ssize_t i = 0; i < count; i++) {
+        libusb_device_descriptor desc;
+        if (libusb_get_device_descriptor(list[i], &desc) == 0 &&
+            desc.idVendor == RC_S380_VENDOR_ID && desc.idProduct == RC_S380_PRODUCT_ID) {
+            ids.push_back(usb_device_id(list[i]));
+        }
     }
+    if (list) libusb_free_device_list(list, 1);
+    return ids;
 }
 
 // Factory function for RC-S380 backend
 #ifdef NFC_BACKEND_RCS380
 std::unique_ptr<NfcTransport> create_nfc_transport() {
-    return std::make_unique<Rcs380Transport>();
+    return create_nfc_transport("");
+}
+
+std::unique_ptr<NfcTransport> create_nfc_transport(const std::string& reader_id) {
+    // SEND_EPAPER_USB_SYNC=1 falls back to blocking transfers
+    const char* sync = std::getenv("SEND_EPAPER_USB_SYNC");
+    return std::make_unique<Rcs380Transport>(!(sync && *sync && std::string(sync) != "0"),
+                                             reader_id);
+}
+
+std::vector<std::string> list_nfc_readers() {
+    return Rcs380Transport::list_readers();
 }
 #endif
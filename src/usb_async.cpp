@@ -0,0 +1,144 @@
+#include "usb_async.hpp"
+
+#include <libusb-1.0/libusb.h>
+
+#include <stdexcept>
+
+// --- UsbEventLoop ---
+
+std::shared_ptr<UsbEventLoop> UsbEventLoop::shared() {
+    static std::mutex mutex;
+    static std::weak_ptr<UsbEventLoop> instance;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto loop = instance.lock();
+    if (!loop) {
+        loop.reset(new UsbEventLoop());
+        instance = loop;
+    }
+    return loop;
+}
+
+UsbEventLoop::UsbEventLoop() {
+    libusb_context* ctx = nullptr;
+    if (libusb_init(&ctx) < 0) {
+        throw std::runtime_error("Failed to initialize libusb");
+    }
+    ctx_ = ctx;
+    thread_ = std::thread([this] { run(); });
+}
+
+UsbEventLoop::~UsbEventLoop() {
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+    libusb_exit(static_cast<libusb_context*>(ctx_));
+}
+
+void UsbEventLoop::run() {
+    auto ctx = static_cast<libusb_context*>(ctx_);
+    while (!stop_) {
+        // Short timeout so the stop flag is noticed without a wakeup transfer
+        timeval tv = {0, 100 * 1000};
+        libusb_handle_events_timeout_completed(ctx, &tv, nullptr);
+    }
+}
+
+// --- UsbAsyncPipe ---
+
+UsbAsyncPipe::UsbAsyncPipe(std::shared_ptr<UsbEventLoop> loop, void* handle,
+                           uint8_t ep_out, uint8_t ep_in,
+                           DataCallback on_data, ErrorCallback on_error)
+    : loop_(std::move(loop)), on_data_(std::move(on_data)), on_error_(std::move(on_error)) {
+    libusb_transfer* in = libusb_alloc_transfer(0);
+    libusb_transfer* out = libusb_alloc_transfer(0);
+    if (!in || !out) {
+        libusb_free_transfer(in);
+        libusb_free_transfer(out);
+        throw std::runtime_error("Failed to allocate USB transfers");
+    }
+    auto dev = static_cast<libusb_device_handle*>(handle);
+    // Timeout 0: the IN transfer waits for as long as the device stays quiet
+    libusb_fill_bulk_transfer(in, dev, ep_in, in_buf_, (int)IN_SIZE,
+                              [](libusb_transfer* t) { in_done(t); }, this, 0);
+    libusb_fill_bulk_transfer(out, dev, ep_out, nullptr, 0,
+                              [](libusb_transfer* t) { out_done(t); }, this, 0);
+    in_ = in;
+    out_ = out;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    submit_in();
+    if (!in_flight_) {
+        libusb_free_transfer(in);
+        libusb_free_transfer(out);
+        throw std::runtime_error("Failed to post USB IN transfer");
+    }
+}
+
+UsbAsyncPipe::~UsbAsyncPipe() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closing_ = true;
+    if (in_flight_) libusb_cancel_transfer(static_cast<libusb_transfer*>(in_));
+    if (out_flight_) libusb_cancel_transfer(static_cast<libusb_transfer*>(out_));
+    cv_.wait(lock, [&] { return !in_flight_ && !out_flight_; });
+    lock.unlock();
+    libusb_free_transfer(static_cast<libusb_transfer*>(in_));
+    libusb_free_transfer(static_cast<libusb_transfer*>(out_));
+}
+
+void UsbAsyncPipe::submit_in() {
+    in_flight_ = libusb_submit_transfer(static_cast<libusb_transfer*>(in_)) == 0;
+}
+
+void UsbAsyncPipe::in_done(void* transfer) {
+    auto t = static_cast<libusb_transfer*>(transfer);
+    auto self = static_cast<UsbAsyncPipe*>(t->user_data);
+
+    // Delivered outside the lock; the destructor waits while the transfer is in flight
+    if (t->status == LIBUSB_TRANSFER_COMPLETED && t->actual_length > 0) {
+        self->on_data_(t->buffer, (size_t)t->actual_length);
+    }
+
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    bool ok = t->status == LIBUSB_TRANSFER_COMPLETED || t->status == LIBUSB_TRANSFER_TIMED_OUT;
+    if (ok && !self->closing_) {
+        self->submit_in();
+        if (!self->in_flight_) self->on_error_("USB read failed: could not resubmit transfer");
+    } else {
+        if (!self->closing_ && t->status != LIBUSB_TRANSFER_CANCELLED) {
+            self->on_error_(t->status == LIBUSB_TRANSFER_NO_DEVICE
+                                ? "USB read failed: device disconnected"
+                                : "USB read failed: transfer error");
+        }
+        self->in_flight_ = false;
+    }
+    // Errors are reported under the lock, before the destructor can see in_flight_ == false
+    self->cv_.notify_all();
+}
+
+void UsbAsyncPipe::out_done(void* transfer) {
+    auto t = static_cast<libusb_transfer*>(transfer);
+    auto self = static_cast<UsbAsyncPipe*>(t->user_data);
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    self->out_status_ = t->status;
+    self->out_flight_ = false;
+    self->cv_.notify_all();
+}
+
+void UsbAsyncPipe::write(const uint8_t* data, size_t size, int timeout_ms) {
+    auto t = static_cast<libusb_transfer*>(out_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closing_) throw std::runtime_error("USB write failed: pipe closed");
+    t->buffer = const_cast<uint8_t*>(data);
+    t->length = (int)size;
+    t->timeout = (unsigned)timeout_ms;
+    int ret = libusb_submit_transfer(t);
+    if (ret < 0) {
+        throw std::runtime_error(std::string("USB write failed: ") + libusb_error_name(ret));
+    }
+    out_flight_ = true;
+    cv_.wait(lock, [&] { return !out_flight_; });
+    if (out_status_ != LIBUSB_TRANSFER_COMPLETED || t->actual_length != (int)size) {
+        throw std::runtime_error(out_status_ == LIBUSB_TRANSFER_TIMED_OUT
+                                     ? "USB write failed: timeout"
+                                     : "USB write failed: transfer error");
+    }
+}
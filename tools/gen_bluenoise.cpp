@@ -0,0 +1,133 @@
+// Generates src/bluenoise_mask.hpp, the 64x64 blue-noise ranks used by --dither bluenoise.
+//
+//   gen_bluenoise > src/bluenoise_mask.hpp   regenerate the table
+//   gen_bluenoise --check                    exit 1 if the shipped table differs
+//
+// The mask is built with Ulichney's void-and-cluster method (toroidal Gaussian
+// energy, sigma 1.5, fixed seed). That takes tens of milliseconds, which every
+// CLI run would pay, so the result ships as a table.
+
+#include "bluenoise_mask.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static std::vector<int> void_and_cluster() {
+    const int n = 64;
+    const int total = n * n;
+    const double sigma = 1.5;
+
+    std::vector<float> kernel(total);
+    for (int dy = 0; dy < n; dy++) {
+        for (int dx = 0; dx < n; dx++) {
+            int wx = std::min(dx, n - dx), wy = std::min(dy, n - dy);
+            kernel[dy * n + dx] = (float)std::exp(-(wx * wx + wy * wy) / (2 * sigma * sigma));
+        }
+    }
+
+    std::vector<uint8_t> bits(total, 0);
+    std::vector<float> energy(total, 0.0f);
+    auto toggle = [&](int p, float sign) {
+        int py = p / n, px = p % n;
+        bits[p] = sign > 0;
+        for (int y = 0; y < n; y++) {
+            const float* krow = &kernel[((y - py + n) % n) * n];
+            float* erow = &energy[y * n];
+            for (int x = 0; x < n; x++) {
+                erow[x] += sign * krow[(x - px + n) % n];
+            }
+        }
+    };
+    // Tightest cluster: set pixel with highest energy; largest void: empty pixel with lowest
+    auto tightest = [&] {
+        int best = -1;
+        for (int i = 0; i < total; i++) {
+            if (bits[i] && (best < 0 || energy[i] > energy[best])) best = i;
+        }
+        return best;
+    };
+    auto largest_void = [&] {
+        int best = -1;
+        for (int i = 0; i < total; i++) {
+            if (!bits[i] && (best < 0 || energy[i] < energy[best])) best = i;
+        }
+        return best;
+    };
+
+    // Initial binary pattern: 10% random points, relaxed until stable
+    std::mt19937 rng(0x5eed);
+    int ones = 0;
+    while (ones < total / 10) {
+        int p = (int)(rng() % total);
+        if (!bits[p]) {
+            toggle(p, 1.0f);
+            ones++;
+        }
+    }
+    for (int iter = 0; iter < total; iter++) {
+        int cluster = tightest();
+        toggle(cluster, -1.0f);
+        int hole = largest_void();
+        toggle(hole, 1.0f);
+        if (hole == cluster) break;
+    }
+
+    std::vector<int> rank(total, 0);
+    const auto proto_bits = bits;
+    const auto proto_energy = energy;
+
+    // Phase 1: remove tightest clusters from the prototype, ranking downwards
+    for (int r = ones - 1; r >= 0; r--) {
+        int p = tightest();
+        toggle(p, -1.0f);
+        rank[p] = r;
+    }
+
+    // Phases 2/3: fill largest voids upwards. With a translation-invariant
+    // kernel the tightest cluster of zeros is exactly the largest void of ones.
+    bits = proto_bits;
+    energy = proto_energy;
+    for (int r = ones; r < total; r++) {
+        int p = largest_void();
+        toggle(p, 1.0f);
+        rank[p] = r;
+    }
+
+    return rank;
+}
+
+int main(int argc, char* argv[]) {
+    auto rank = void_and_cluster();
+
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        if (!std::equal(rank.begin(), rank.end(), BLUENOISE_RANKS)) {
+            std::cerr << "src/bluenoise_mask.hpp does not match the generator" << std::endl;
+            return 1;
+        }
+        std::cout << "src/bluenoise_mask.hpp matches the generator" << std::endl;
+        return 0;
+    }
+
+    std::cout << "#pragma once\n"
+              << "\n"
+              << "// 64x64 blue-noise mask: the rank (0..4095) of every cell, row by row.\n"
+              << "// Generated by tools/gen_bluenoise.cpp; do not edit.\n"
+              << "\n"
+              << "#include <cstdint>\n"
+              << "\n"
+              << "static const int BLUENOISE_SIZE = 64;\n"
+              << "\n"
+              << "static const uint16_t BLUENOISE_RANKS[64 * 64] = {\n";
+    for (size_t i = 0; i < rank.size(); i += 16) {
+        std::cout << "   ";
+        for (size_t k = i; k < i + 16; k++) std::cout << " " << rank[k] << ",";
+        std::cout << "\n";
+    }
+    std::cout << "};\n";
+    return 0;
+}